@@ -1,34 +1,323 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <map>
 #include <unordered_map>
+#include <map>
 #include <algorithm>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <queue>
+#include <functional>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <csignal>
+#include <cmath>
+#include <random>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <dirent.h>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 using namespace std;
 using namespace std::chrono;
 
-int totalFrequentItemsets = 0; //Global counter to keep track of the total number of frequent item sets
+bool countAllocations = false; //count heap allocations (--stats); off by default so normal runs pay nothing but a branch
+atomic<long long> allocationCount(0); //heap allocations made while counting
+atomic<long long> allocationBytes(0); //bytes requested by those allocations
+
+void* allocate(size_t size, size_t alignment = 0) { //malloc for the operators below: counts the allocation and, while
+                                                     //malloc fails, calls the new_handler (which may throw); nullptr
+                                                     //once there is no handler. A nonzero alignment uses posix_memalign.
+    if (countAllocations) {
+        allocationCount.fetch_add(1, memory_order_relaxed);
+        allocationBytes.fetch_add(size, memory_order_relaxed);
+    }
+    while (true) {
+        void* p = nullptr;
+        if (!alignment)
+            p = malloc(size ? size : 1);
+        else if (posix_memalign(&p, max(alignment, sizeof(void*)), size ? size : 1) != 0)
+            p = nullptr;
+        if (p)
+            return p;
+        new_handler handler = get_new_handler();
+        if (!handler)
+            return nullptr;
+        handler();
+    }
+}
+
+//Every form of new and delete is replaced, the C++17 aligned ones included, so whichever one a container or the library
+//picks, the pair matches and the allocation is counted
+void* operator new(size_t size) {
+    void* p = allocate(size);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return ::operator new(size); }
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) { //a new_handler gave up with bad_alloc
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void* operator new(size_t size, align_val_t alignment) {
+    void* p = allocate(size, (size_t)alignment);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+void* operator new[](size_t size, align_val_t alignment) { return ::operator new(size, alignment); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept {
+    try {
+        return allocate(size, (size_t)alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t& tag) noexcept {
+    return ::operator new(size, alignment, tag);
+}
+
+//Both kinds of allocation are released with free(). Once operator new and delete are inlined into a caller, GCC sees
+//free() on a pointer from operator new and warns about a mismatch that is not there, since both are defined here.
+#if !defined(__clang__) && __GNUC__ >= 11 //the warning is new in GCC 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { ::operator delete(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { ::operator delete(p); }
+void operator delete(void* p, align_val_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, align_val_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, size_t, align_val_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t, align_val_t) noexcept { ::operator delete(p); }
+void operator delete(void* p, align_val_t, const nothrow_t&) noexcept { ::operator delete(p); }
+void operator delete[](void* p, align_val_t, const nothrow_t&) noexcept { ::operator delete(p); }
+#if !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+struct ItemDictionary { //Maps each "attributeName:value" string to a dense integer ID
+                        //IDs are ranked by global frequency: ID 0 is the most frequent item
+                        //The tree and the miner only ever see IDs; strings come back only when output is written
+    vector<string> attributeNames; //names of the columns; empty for basket data, where a value is the whole item
+    vector<string> names; //names[id] is the original "attributeName:value" string
+    vector<int> counts;   //counts[id] is the global support of the item
+    vector<int> columns;  //columns[id] is the column the item came from (-1 for basket data)
+
+    int intern(int column, const char* value, size_t length) { //return the ID for a field read from column, adding it if it was not seen before
+                                                               //value points straight into the input bytes; nothing is allocated unless the item is new
+        if (slots.empty() || 2 * (names.size() + 1) > slots.size())
+            rehash(max<size_t>(64, 2 * slots.size()));
+        size_t slot = hash(column, value, length) & (slots.size() - 1);
+        while (slots[slot] >= 0) { //linear probing until we find the item or an empty slot
+            int id = slots[slot];
+            if (columns[id] == column && matches(id, value, length))
+                return id;
+            slot = (slot + 1) & (slots.size() - 1);
+        }
+        int id = names.size();
+        slots[slot] = id;
+        if (column >= 0)
+            names.push_back(attributeNames[column] + ":" + string(value, length));
+        else
+            names.push_back(string(value, length));
+        counts.push_back(0);
+        columns.push_back(column);
+        return id;
+    }
+
+    vector<int> rankByFrequency() { //Renumber the IDs by descending global frequency
+                                    //Returns a table that maps each old ID to its new ID
+        vector<int> order(names.size());
+        for (int i = 0; i < (int)order.size(); i++)
+            order[i] = i;
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return counts[a] > counts[b]; });
+
+        vector<int> remap(names.size());
+        vector<string> rankedNames(names.size());
+        vector<int> rankedCounts(names.size());
+        vector<int> rankedColumns(names.size());
+        for (int rank = 0; rank < (int)order.size(); rank++) {
+            remap[order[rank]] = rank;
+            rankedNames[rank].swap(names[order[rank]]);
+            rankedCounts[rank] = counts[order[rank]];
+            rankedColumns[rank] = columns[order[rank]];
+        }
+        names.swap(rankedNames);
+        counts.swap(rankedCounts);
+        columns.swap(rankedColumns);
+        rehash(slots.size());
+        return remap;
+    }
+
+    void reindex() { //rebuild the lookup table after names and columns were filled in directly (see loadTree)
+        size_t size = 64;
+        while (size < 2 * (names.size() + 1))
+            size *= 2;
+        rehash(size);
+    }
+
+private:
+    vector<int> slots; //open-addressing hash table of IDs (-1 = empty); its size is a power of two
+
+    static size_t hash(int column, const char* value, size_t length) { //FNV-1a over the bytes, mixed with the column
+        size_t h = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; i++) {
+            h ^= (unsigned char)value[i];
+            h *= 1099511628211ULL;
+        }
+        return h ^ ((size_t)(column + 1) * 0x9E3779B97F4A7C15ULL);
+    }
+
+    size_t valueOffset(int id) const { //where the value starts inside names[id]
+        return columns[id] >= 0 ? attributeNames[columns[id]].size() + 1 : 0;
+    }
+
+    bool matches(int id, const char* value, size_t length) const {
+        size_t offset = valueOffset(id);
+        return names[id].size() == offset + length && memcmp(names[id].data() + offset, value, length) == 0;
+    }
+
+    void rehash(size_t size) { //rebuild the table with the given number of slots
+        slots.assign(size, -1);
+        for (int id = 0; id < (int)names.size(); id++) {
+            size_t offset = valueOffset(id);
+            size_t slot = hash(columns[id], names[id].data() + offset, names[id].size() - offset) & (size - 1);
+            while (slots[slot] >= 0)
+                slot = (slot + 1) & (size - 1);
+            slots[slot] = id;
+        }
+    }
+};
+
+ItemDictionary dictionary; //Global item dictionary shared by the loader, the miner and the output
+
+const size_t MAX_TRANSACTIONS = INT_MAX; //item supports and node counts are int, so no input may hold more transactions
 
 struct FPNode { //define struc called FPNode
-    string item; //string variable that stores the item name in the transaction
+    int item; //item ID in the dictionary (-1 for the root)
     int count;  //count to store the frequency
     FPNode* parent; //Pointer to the parent node in the FPtree
     FPNode* nodeLink; //Node to link items together (algorithm states they have to be linked in the header table)
-    map<string, FPNode*> children; //map to store the child nodes 
-                                   //String is the item name and FPNode* is the pointer to the FPNode child
+    FPNode* firstChild; //First child of this node; children are kept in ascending item ID order
+    FPNode* nextSibling; //Next child of this node's parent
 
     // Constructor for FPNode
-    FPNode(string i = "", FPNode* p = nullptr)
-        : item(i),         // item name
+    FPNode(int i = -1, FPNode* p = nullptr)
+        : item(i),         // item ID
           count(1),        // initial count
           parent(p),       // pointer to parent
-          nodeLink(nullptr) // next node link
+          nodeLink(nullptr), // next node link
+          firstChild(nullptr), // no children yet
+          nextSibling(nullptr) // no siblings yet
     {}
 };
 
+class NodeArena { //Owns every node of one FP-tree
+                  //Nodes are carved out of large blocks instead of one new per node,
+                  //and the whole tree is released at once with reset()
+                  //Nodes with many children also get an index of them here, so finding a child stays cheap
+public:
+    NodeArena() : current(nullptr), nextBlock(0), used(BLOCK_SIZE) {}
+    ~NodeArena() {
+        for (FPNode* block : blocks)
+            delete[] block;
+    }
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    FPNode* newNode(int item = -1, FPNode* parent = nullptr) { //construct a node inside the arena
+        if (used == BLOCK_SIZE) { //current block is full, move on to the next one
+            if (nextBlock == blocks.size()) //allocate a new block only if no released block is left to reuse
+                blocks.push_back(new FPNode[BLOCK_SIZE]);
+            current = blocks[nextBlock++];
+            used = 0;
+        }
+        FPNode* node = &current[used++];
+        *node = FPNode(item, parent);
+        created++;
+        return node;
+    }
+
+    size_t nodesCreated() const { return created; } //nodes handed out since the arena was made, across resets
+    size_t nodesInUse() const { return nextBlock ? (nextBlock - 1) * BLOCK_SIZE + used : 0; } //nodes of the current tree
+
+    void reset() { //release every node at once; the blocks are kept so the next tree can reuse them
+        nextBlock = 0;
+        used = BLOCK_SIZE;
+        childIndex.clear();
+    }
+
+    FPNode** childLink(FPNode* parent, int item) { //link in the child list of parent that points to the child for item,
+                                                   //or to the first child after it; the index is made on first use
+        map<int, FPNode*>& children = childIndex[parent];
+        if (children.empty())
+            for (FPNode* child = parent->firstChild; child; child = child->nextSibling)
+                children.emplace_hint(children.end(), child->item, child);
+        auto next = children.lower_bound(item);
+        return next == children.begin() ? &parent->firstChild : &prev(next)->second->nextSibling;
+    }
+
+    void addChild(FPNode* parent, FPNode* child) { //record a child just linked into the list of parent
+        if (childIndex.empty())
+            return;
+        auto children = childIndex.find(parent);
+        if (children != childIndex.end())
+            children->second.emplace(child->item, child);
+    }
+
+    void moveChildren(FPNode* from, FPNode* to) { //the children of from were hung under to
+        auto children = childIndex.find(from);
+        if (children == childIndex.end())
+            return;
+        childIndex[to].swap(children->second);
+        childIndex.erase(from);
+    }
+
+    void swap(NodeArena& other) { //exchange the trees of two arenas
+        blocks.swap(other.blocks);
+        std::swap(current, other.current);
+        std::swap(nextBlock, other.nextBlock);
+        std::swap(used, other.used);
+        std::swap(created, other.created);
+        childIndex.swap(other.childIndex);
+    }
+
+    static const size_t INDEX_FANOUT = 32; //children walked in the sorted list before the index is used
+
+private:
+    static const size_t BLOCK_SIZE = 4096; //nodes per block
+    vector<FPNode*> blocks; //blocks allocated so far
+    FPNode* current; //block that new nodes are taken from
+    size_t nextBlock; //index of the block to use once current is full
+    size_t used; //nodes already handed out from the current block
+    size_t created = 0; //nodes handed out in total
+    unordered_map<FPNode*, map<int, FPNode*>> childIndex; //children by item of the nodes with many children
+};
+
+typedef vector<vector<FPNode*>> HeaderTable; //headerTable[id] holds every node of item id in the tree
+
     string cleanItem(const string& item) { 
     // Function to remove anything before "#" that may be present separating the features
     size_t hashPos = item.find('#'); // Find the position of '#' in the string
@@ -37,327 +326,2651 @@ struct FPNode { //define struc called FPNode
     return item.substr(hashPos + 1); // If found, return substring after '#'
 }
 
-void deleteFPTree(FPNode* node) { //Function to delete FPtree from memory. 
-                                  //Needed to avoid memory leaks
-                                  //Delete children first, then the parent.
-    if (!node) return; //If node is null, do nothing
-    for (auto& child : node->children) //recursively delete all children
-        deleteFPTree(child.second); //delete FPNode pointer
-    delete node;    //delete the current node
-}
-
 void insertTransaction(FPNode* current, //pointer to the current node in the FPtree
                                         //Tells us where the transaction is being inserted
-                       const vector<string>& transaction, //vector of items in a transaction
-                       map<string, vector<FPNode*>>& headerTable, //headerTable that links each unique item to all its occurrences in the tree
-                       int count = 1, //integer to count the number of transactions that occurred
-                       int index = 0) //index for the current item in the transaction we are currently processing
+                       const vector<int>& transaction, //vector of item IDs in a transaction
+                       HeaderTable& headerTable, //headerTable that links each unique item to all its occurrences in the tree
+                       NodeArena& arena, //arena that owns the nodes of this tree
+                       int count = 1) //integer to count the number of transactions that occurred
 {
-    if (index >= transaction.size()) //Base case: If we already processed all items in the transaction
-        return;
+    for (int item : transaction) { //Walk down the tree one item at a time, so long transactions do not use stack frames
+        FPNode* nextNode;   //Declare a pointer to the next node in the tree
 
-    string item = transaction[index]; //Get the current item in transaction and store it to item
-    FPNode* nextNode;   //Declare a pointer to the next node in the tree
+        FPNode** link = &current->firstChild; //Walk the sorted child list to find the item or the place where it belongs
+        for (size_t steps = 0; *link && (*link)->item < item; steps++) {
+            if (steps == NodeArena::INDEX_FANOUT) { //a long list (e.g. the root of sparse data): look it up instead
+                link = arena.childLink(current, item);
+                break;
+            }
+            link = &(*link)->nextSibling;
+        }
 
-    if (current->children.count(item)) {  //Check to see if the current node already has a child for this item
-        current->children[item]->count += count; //Increment the count of that child
-        nextNode = current->children[item]; //Move to the pointer to that existing child
-    } else { //Second Case: The item does not exist as a child of the current node 
-             //If this is the case, we have to make a new node.
-        nextNode = new FPNode(item, current); //Create a new node for this item (CurrentNode as the parent)
-        nextNode->count = count; //Set the count of the node to the frequency
-        current->children[item] = nextNode; //link the new child node to the current node by adding it to the children hashmap 
+        if (*link && (*link)->item == item) {  //Check to see if the current node already has a child for this item
+            (*link)->count += count; //Increment the count of that child
+            nextNode = *link; //Move to the pointer to that existing child
+        } else { //Second Case: The item does not exist as a child of the current node 
+                 //If this is the case, we have to make a new node.
+            nextNode = arena.newNode(item, current); //Create a new node for this item (CurrentNode as the parent)
+            nextNode->count = count; //Set the count of the node to the frequency
+            nextNode->nextSibling = *link; //link the new child node into the child list, keeping it sorted
+            *link = nextNode;
+            arena.addChild(current, nextNode);
 
-        if (!headerTable[item].empty()) { //check to see if the header table already has nodes for this item
-                                          //if this is the case, get the last node added for this item and link it to the new node
-                                          //this creates a linking between all nodes for the same item so we can find them easily later
-            FPNode* last = headerTable[item].back(); 
-            last->nodeLink = nextNode;
+            if (!headerTable[item].empty()) { //check to see if the header table already has nodes for this item
+                                              //if this is the case, get the last node added for this item and link it to the new node
+                                              //this creates a linking between all nodes for the same item so we can find them easily later
+                FPNode* last = headerTable[item].back(); 
+                last->nodeLink = nextNode;
+            }
+            headerTable[item].push_back(nextNode); //add the new node to the header table 
         }
-        headerTable[item].push_back(nextNode); //add the new node to the header table 
-    }
 
-    insertTransaction(nextNode, transaction, headerTable, count, index + 1); //recursive call to insert the next item in the transaction
+        current = nextNode; //continue with the next item below this node
+    }
 }
 
-void printFPTree(FPNode* node, int depth = 0, bool isLast = true) { 
+void printFPTree(FPNode* root) { 
     // Function to print the FP-tree in a readable format
-    if (depth == 0) { //Check to see if ROOT
-        cout << "ROOT\n"; //if true, print ROOT
-    } else {
+    // Uses an explicit stack instead of recursion so deep trees cannot overflow the call stack
+    cout << "ROOT\n";
+    vector<pair<FPNode*, int>> stack; //nodes still to print, with their depth below the root
+    if (root->firstChild)
+        stack.push_back({root->firstChild, 1});
+
+    while (!stack.empty()) {
+        FPNode* node = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+
         cout << string((depth - 1) * 6, ' ');  //Create spaces for the indentation when printing FPTree
                                                // depth - 1 so that the first level under the root has 0 spaces
                                                // *6 each level gets 6 spaces to make the Tree
                                               // Note: Can be changed to *6, *8, etc., to make tree easier to read
         // Print branch symbol
-        if (isLast) {
+        if (node->nextSibling == nullptr) {
             cout << "\\-- "; // Last child in this level
         } else {
             cout << "|-- ";  // Not the last child
         }
         // Print the item and its count
-        cout << cleanItem(node->item) << " [" << node->count << "]\n";
+        cout << cleanItem(dictionary.names[node->item]) << " [" << node->count << "]\n";
+
+        if (node->nextSibling) //the next sibling is printed after this node's whole subtree
+            stack.push_back({node->nextSibling, depth});
+        if (node->firstChild) //children come first, directly under this node
+            stack.push_back({node->firstChild, depth + 1});
+    }
+}
+
+class ResultSink { //Receives every frequent itemset the miner finds
+                   //The miner only calls add(); what happens to the itemset is up to the sink.
+                   //Each mining thread gets its own sink, so add() never has to lock.
+public:
+    virtual ~ResultSink() {}
+    virtual void add(const vector<int>& itemset, int support) = 0; //itemset holds item IDs, support is its frequency
+    virtual void flush() {} //write out anything still buffered; called once the miner is done
+    virtual int threshold() const { return 0; } //support below which the sink no longer wants itemsets
+                                                //The miner skips everything below it; a top-k sink raises it while mining.
+
+    long long count = 0; //number of frequent itemsets received
+
+protected:
+    const vector<int>& canonical(const vector<int>& itemset) { //the items of itemset by ascending ID, the order the sinks
+                                                              //write them in, whichever engine or mining order found them
+        sorted.assign(itemset.begin(), itemset.end());
+        sort(sorted.begin(), sorted.end());
+        return sorted;
+    }
+
+private:
+    vector<int> sorted; //scratch for canonical()
+};
+
+mutex outputMutex; //Serializes the writes of the sinks of different threads to a shared stream
+
+class CountSink : public ResultSink { //Only counts the itemsets, so benchmarks measure the mining and not the output
+public:
+    void add(const vector<int>&, int) override { count++; }
+};
+
+class TextSink : public ResultSink { //Writes "{ item item } : support" lines
+                                     //Lines are formatted into a private buffer and written in large chunks
+public:
+    explicit TextSink(ostream& os) : os(os) {}
+    ~TextSink() { flush(); }
+
+    void add(const vector<int>& itemset, int support) override {
+        text += "{ ";
+        for (int id : canonical(itemset)) {
+            text += cleanItem(dictionary.names[id]);
+            text += ' ';
+        }
+        text += "} : ";
+        text += to_string(support);
+        text += '\n';
+        count++;
+        if (text.size() >= FLUSH_SIZE)
+            flush();
+    }
+
+    void flush() override {
+        if (text.empty())
+            return;
+        lock_guard<mutex> lock(outputMutex);
+        os.write(text.data(), text.size());
+        text.clear();
     }
-    // Iterate through children
-    int index = 0;
-    int numChildren = node->children.size(); // assign the total number of children for the current node to numChildren
-    for (auto it = node->children.begin(); it != node->children.end(); ++it, ++index) {  //loop through all children of the current node
-        bool lastChild = (index == numChildren - 1); // Check if this child is the last
-        printFPTree(it->second, depth + 1, lastChild); // Recursive call for child node until all nodes in the tree are printed
+
+private:
+    static const size_t FLUSH_SIZE = 1 << 16; //buffer size that triggers a write
+    ostream& os; //stream that receives the text
+    string text; //formatted lines that have not been written yet
+};
+
+void writeVarint(string& out, unsigned long long value) { //append value as a LEB128 varint: 7 bits per byte, high bit set if more bytes follow
+    while (value >= 0x80) {
+        out += (char)((value & 0x7F) | 0x80);
+        value >>= 7;
     }
+    out += (char)value;
 }
 
-void mineFPTree(FPNode* root, map<string, vector<FPNode*>>& headerTable, int minSupport, vector<string> currentPattern = {}) { 
-    // Function to recursively mine frequent patterns from the FP-tree
-    // root - pointer to the root of the current FP tree
-    // headerTable - links each item to all its nodes in the FP tree
-    // minSupport - the minimum frequency an itemset must have to be considered frequent (also known as the threshold)
-    // currentPattern - the frequent itemset we are building as we go deeper in the tree
+class BinarySink : public ResultSink { //Writes each itemset as varints: support, length, then the item IDs
+                                       //Frequent items have small IDs, so most IDs take a single byte.
+                                       //writeHeader() stores the dictionary first so the file can be decoded on its own.
+public:
+    explicit BinarySink(ostream& os) : os(os) {}
+    ~BinarySink() { flush(); }
+
+    static void writeHeader(ostream& os) { //"FPGB", the number of items, then each item name as length + bytes
+        string header = "FPGB";
+        writeVarint(header, dictionary.names.size());
+        for (const string& name : dictionary.names) {
+            writeVarint(header, name.size());
+            header += name;
+        }
+        os.write(header.data(), header.size());
+    }
+
+    void add(const vector<int>& itemset, int support) override {
+        writeVarint(data, support);
+        writeVarint(data, itemset.size());
+        for (int id : canonical(itemset))
+            writeVarint(data, id);
+        count++;
+        if (data.size() >= FLUSH_SIZE)
+            flush();
+    }
 
-    vector<pair<string, int>> items; //vector to store the list of items and their frequency in the current tree
+    void flush() override {
+        if (data.empty())
+            return;
+        lock_guard<mutex> lock(outputMutex);
+        os.write(data.data(), data.size());
+        data.clear();
+    }
+
+private:
+    static const size_t FLUSH_SIZE = 1 << 16; //buffer size that triggers a write
+    ostream& os; //stream that receives the records
+    string data; //encoded records that have not been written yet
+};
+
+class TopKCollector { //Keeps the k most frequent itemsets reported by the TopKSinks of all threads
+                      //The k-th best support seen so far is the threshold: nothing below it can still make the top k,
+                      //so the miner can prune with it. Itemsets tied with the k-th best support are all kept.
+public:
+    TopKCollector(size_t k, int minSupport) : k(k), current(minSupport) {}
+
+    int threshold() const { return current.load(memory_order_relaxed); }
+
+    void add(const vector<int>& itemset, int support) {
+        if (support < threshold()) //most itemsets stop here, without taking the lock
+            return;
+        lock_guard<mutex> lock(collectorMutex);
+        if (support < current.load(memory_order_relaxed))
+            return;
+        kept.push_back({itemset, support});
+        best.push(support);
+        if (best.size() > k)
+            best.pop();
+        if (best.size() == k && best.top() > current.load(memory_order_relaxed)) {
+            current.store(best.top(), memory_order_relaxed);
+            if (kept.size() >= 2 * compactedSize) { //drop the itemsets that fell below the threshold now and then
+                int limit = best.top();
+                kept.erase(remove_if(kept.begin(), kept.end(), [&](const pair<vector<int>, int>& entry) {
+                    return entry.second < limit;
+                }), kept.end());
+                compactedSize = max(k, kept.size());
+            }
+        }
+    }
+
+    void write(ResultSink& out) { //pass the top k itemsets to out, most frequent first
+        int limit = current.load(memory_order_relaxed);
+        stable_sort(kept.begin(), kept.end(), [](const pair<vector<int>, int>& a, const pair<vector<int>, int>& b) {
+            return a.second > b.second;
+        });
+        for (auto& entry : kept)
+            if (entry.second >= limit)
+                out.add(entry.first, entry.second);
+        out.flush();
+    }
+
+private:
+    size_t k; //number of itemsets asked for
+    atomic<int> current; //support of the k-th best itemset so far (minSupport until k itemsets were seen)
+    mutex collectorMutex; //guards kept and best
+    priority_queue<int, vector<int>, greater<int>> best; //supports of the k best itemsets so far, smallest on top
+    vector<pair<vector<int>, int>> kept; //itemsets that were at or above the threshold when they arrived
+    size_t compactedSize = 1; //size of kept after the last compaction
+};
+
+class TopKSink : public ResultSink { //Per-thread front end of a TopKCollector
+public:
+    explicit TopKSink(TopKCollector& collector) : collector(collector) {}
+
+    void add(const vector<int>& itemset, int support) override { collector.add(itemset, support); }
+    int threshold() const override { return collector.threshold(); }
+
+private:
+    TopKCollector& collector; //collector shared by the sinks of all threads
+};
+
+vector<pair<int, int>> frequentItems(const HeaderTable& headerTable, int minSupport) {
+    // Function to find the frequent items of a tree, sorted by support (ascending) - stated by the FPTree algorithm
+    // Ties are broken by descending ID, so the items come in exactly the reverse of their order along the tree paths
+    vector<pair<int, int>> items; //vector to store the list of item IDs and their frequency in the current tree
 
-    for (auto& entry : headerTable) { //Loop through each item in the header table
+    for (int item = 0; item < (int)headerTable.size(); item++) { //Loop through each item in the header table
         int total = 0; //variable to store count of the item
-        for (FPNode* n : entry.second)  // loop through each FP-tree node that contains the item
-                                        // entry.second represents all the FP-tree ndoes that contain the item
-            total += n->count;          // counthe number of tiems this item appears in the tree
+        for (FPNode* n : headerTable[item])  // loop through each FP-tree node that contains the item
+            total += n->count;          // count the number of times this item appears in the tree
         if (total >= minSupport)        //if the count is greater than the minimum support threshold, then it is considered frequent 
-            items.push_back({entry.first, total}); //store the item name and it's total frequency in the items vector
-    }
-    // Sort items by support (ascending) - stated by the FPTree algorithm
-    sort(items.begin(), items.end(), [](auto& a, auto& b) { return a.second < b.second; });
-
-    for (auto& entry : items) { // loop through each frequent item 
-                                // entry is a map where <string,int> are stored
-        string item = entry.first; // entry.first represents the item name (for example: "Eggs")
-        int support = entry.second; //entry.second represents the frequency of that item
-
-        vector<string> newPattern = currentPattern; // Make a vector that creates of a copy of the pattern of items we currently have
-        newPattern.push_back(item); // add the current item to the new pattern
-    
-        cout << "{ ";                   // Print the current frequent pattern
-        for (const string& s : newPattern)
-            cout << cleanItem(s) << " ";
-        cout << "} : " << support << "\n";
-
-        totalFrequentItemsets++; // increment count for each printed frequent pattern
-
-        vector<pair<vector<string>, int>> conditionalPatterns; //create a vector to store all peaths leading up to the occurences of the current tiem
-                                                               //The reason for this is because to find the larger patterns that contain the current item, we need to look at all the transactions that contain it
-        for (FPNode* node : headerTable[item]) { //loop through every FP-tree node that contains the current item (we use the hash function for this)
-            vector<string> path;        //Create a new vector to store the items along the path from the root to the current node
-            int pathCount = node->count; //store the frequency of that node to pathCount
-            FPNode* parent = node->parent; //start from the parent node of the current node in order to trace back to the root (we do not include the item at the ucrrent node because we only consider the items before it)
-            while (parent && !parent->item.empty()) { //while there is a parent node that is not null and is not the root
-                                                      // add the parents item to path and move up to the parent's parent
-                path.push_back(parent->item);
-                parent = parent->parent;
-            }
-            if (!path.empty()) {   //check to see if path is non-empty
-                reverse(path.begin(), path.end()); //reverse the vector so the items go from root -> leaf
-                                                   // The algorithm description in the textbook mentions we always collect from bottom->up and then construct up->bottom
-                conditionalPatterns.push_back({path, pathCount}); //add this path to the conditionalPatterns vector
-            }
-        }
-
-        if (!conditionalPatterns.empty()) { // check to see if the vector has any conditional patterns
-            unordered_map<string, int> conditionalFreq; // hashmap to store item name and the frequency of each item in the conditionalFreq vector
-            for (auto& pattern : conditionalPatterns) // loop through each item in the vector
-                                                      // pattern.first is the vector of items in the path
-                                                      // pattern.second is the count of that path
-                for (auto& pathItem : pattern.first) // loop through each item in the path
-                    conditionalFreq[pathItem] += pattern.second; //for each item in the path, add the count of to it's total in the map
-
-            FPNode* conditionalRoot = new FPNode(); // Create a new FP tree root for the conditional tree of the current item
-            map<string, vector<FPNode*>> conditionalHeader; // headerTable for the conditional tree
-                                                            // LInks each item to all nodes in the conditional tree 
-
-            for (auto& pattern : conditionalPatterns) { // loop over each conditional path 
-                vector<string> filteredTransaction;  // vector that will store the frequent patterns of the condtional tree
-                for (auto& pathItem : pattern.first) { // loop through each item in the current conditional path
-                    if (conditionalFreq[pathItem] >= minSupport) // check to see if the frequency of the item is ATLEAST the support
-                        filteredTransaction.push_back(pathItem); // if it is, add it to the filtered transaction for building the conditional FP-tree
-                }
-                sort(filteredTransaction.begin(), filteredTransaction.end(), // sort the filtered transcactions with respect to the frequencies
-                                                                             // crucial part of the FP Growth Algorithm
-                     [&](const string& a, const string& b) {
+            items.push_back({item, total}); //store the item ID and it's total frequency in the items vector
+    }
+    sort(items.begin(), items.end(), [](auto& a, auto& b) {
+        return a.second != b.second ? a.second < b.second : a.first > b.first;
+    });
+    return items;
+}
+
+struct ConditionalScratch { //Buffers buildConditionalTree reuses from one conditional tree to the next,
+                            //so building a tree allocates nothing once they have grown large enough
+    vector<int> pathItems; //items of every prefix path, root -> leaf, one path after another
+    vector<size_t> pathStarts; //path p is pathItems[pathStarts[p] .. pathStarts[p + 1])
+    vector<int> pathCounts; //count of each path
+    vector<int> conditionalFreq; //frequency of each item ID across the conditional pattern base
+    vector<int> filteredTransaction; //the frequent items of one path, in conditional tree order
+};
+
+FPNode* buildConditionalTree(const HeaderTable& headerTable, int item, int minSupport,
+                             NodeArena& conditionalArena, HeaderTable& conditionalHeader, ConditionalScratch& scratch) {
+    // Function to build the conditional FP-tree of one item from its conditional pattern base
+    // Only reads headerTable and the tree behind it, so different items of the same tree can be handled at the same time
+    // conditionalArena - arena that receives the nodes of the conditional tree (the caller resets it)
+    // conditionalHeader - header table of the conditional tree
+    // scratch - working buffers; each thread needs its own
+    // Returns the root of the conditional tree, or nullptr if the conditional tree is empty
+
+    for (auto& nodes : conditionalHeader) //start from an empty header table but keep its memory for reuse
+        nodes.clear();
+
+    vector<int>& pathItems = scratch.pathItems; //all paths leading up to the occurences of the current item
+                                                //The reason for this is because to find the larger patterns that contain the current item, we need to look at all the transactions that contain it
+    vector<size_t>& pathStarts = scratch.pathStarts;
+    vector<int>& pathCounts = scratch.pathCounts;
+    pathItems.clear();
+    pathStarts.assign(1, 0);
+    pathCounts.clear();
+    int maxItem = 0; // every item on a conditional path is an ancestor of the current item,
+                     // so the conditional tables only need to cover the IDs seen on those paths
+    for (FPNode* node : headerTable[item]) { //loop through every FP-tree node that contains the current item
+        int pathCount = node->count; //store the frequency of that node to pathCount
+        FPNode* parent = node->parent; //start from the parent node of the current node in order to trace back to the root (we do not include the item at the current node because we only consider the items before it)
+        while (parent && parent->item >= 0) { //while there is a parent node that is not null and is not the root
+                                              // add the parents item to the path and move up to the parent's parent
+            pathItems.push_back(parent->item);
+            maxItem = max(maxItem, parent->item + 1);
+            parent = parent->parent;
+        }
+        if (pathItems.size() > pathStarts.back()) {   //check to see if the path is non-empty
+            reverse(pathItems.begin() + pathStarts.back(), pathItems.end()); //reverse the path so the items go from root -> leaf
+                                               // The algorithm description in the textbook mentions we always collect from bottom->up and then construct up->bottom
+            pathStarts.push_back(pathItems.size()); //the path is complete
+            pathCounts.push_back(pathCount);
+        }
+    }
+
+    if (!pathCounts.empty()) { // check to see if there are any conditional patterns
+        vector<int>& conditionalFreq = scratch.conditionalFreq;
+        conditionalFreq.assign(maxItem, 0);
+        for (size_t p = 0; p < pathCounts.size(); p++) // loop through each path
+            for (size_t i = pathStarts[p]; i < pathStarts[p + 1]; i++) // loop through each item in the path
+                conditionalFreq[pathItems[i]] += pathCounts[p]; //for each item in the path, add the count of the path to it's total
+
+        FPNode* conditionalRoot = conditionalArena.newNode(); // Create a new FP tree root for the conditional tree of the current item
+        if ((int)conditionalHeader.size() < maxItem) // headerTable for the conditional tree
+            conditionalHeader.resize(maxItem);       // LInks each item to all nodes in the conditional tree 
+        bool inserted = false;
+
+        vector<int>& filteredTransaction = scratch.filteredTransaction; // will store the frequent items of each path
+        for (size_t p = 0; p < pathCounts.size(); p++) { // loop over each conditional path 
+            filteredTransaction.clear();
+            for (size_t i = pathStarts[p]; i < pathStarts[p + 1]; i++) { // loop through each item in the current conditional path
+                if (conditionalFreq[pathItems[i]] >= minSupport) // check to see if the frequency of the item is ATLEAST the support
+                    filteredTransaction.push_back(pathItems[i]); // if it is, add it to the filtered transaction for building the conditional FP-tree
+            }
+            sort(filteredTransaction.begin(), filteredTransaction.end(), // sort the filtered transcactions with respect to the frequencies
+                                                                         // crucial part of the FP Growth Algorithm
+                 [&](int a, int b) { // ties are broken by ID so every path uses the same order
+                     if (conditionalFreq[a] != conditionalFreq[b])
                          return conditionalFreq[a] > conditionalFreq[b];
-                     });
-                if (!filteredTransaction.empty()) // If it still contains at least one frequent item
-                    insertTransaction(conditionalRoot, filteredTransaction, conditionalHeader, pattern.second); //Insert the filtered and sorted transacation into the conditional FP-tree
+                     return a < b;
+                 });
+            if (!filteredTransaction.empty()) { // If it still contains at least one frequent item
+                insertTransaction(conditionalRoot, filteredTransaction, conditionalHeader, conditionalArena, pathCounts[p]); //Insert the filtered and sorted transacation into the conditional FP-tree
+                inserted = true;
             }
-            //After all conditional paths are insereted, recursively call the mineFPtree function 
-            if (!conditionalHeader.empty())
-                mineFPTree(conditionalRoot, conditionalHeader, minSupport, newPattern);
+        }
+        return inserted ? conditionalRoot : nullptr;
+    }
+    return nullptr;
+}
 
-            deleteFPTree(conditionalRoot); //free the memory for the conditional FP-tree
+template <typename Emit>
+void forEachSubset(const vector<int>& items, size_t count, vector<int>& pattern, Emit emit) {
+    // Function to call emit() once for every subset of items[0 .. count-1], including the empty one
+    // The chosen items are appended to pattern while emit() runs and removed again afterwards.
+    // Subsets are walked with an explicit stack of chosen positions, so long paths do not recurse.
+    emit();
+    vector<size_t> chosen; //positions in items of the items currently appended to pattern
+    size_t next = 0; //next position that may be added
+    while (true) {
+        if (next < count) { //extend the subset with the next item
+            chosen.push_back(next);
+            pattern.push_back(items[next]);
+            next++;
+            emit();
+        } else { //no item left to add, drop the last one and try the positions after it
+            if (chosen.empty())
+                break;
+            next = chosen.back() + 1;
+            chosen.pop_back();
+            pattern.pop_back();
         }
     }
 }
 
-int main() {
-    cout << "FP-Growth Algorithm\n";
-    cout << "Available Datasets:\n";
-    cout << " 1. Skin Segmentation\n";
-    cout << " 2. Adult\n";
-    cout << " 3. Agaricus-Lepiota (Mushroom)\n";
-    cout << " 4. Car Evaluation\n";
-    cout << " 5. Nursery\n";
-    cout << " 6. Letter Recognition\n";
-    cout << " 7. King-Rook vs King-Pawn (Chess)\n";
-    cout << " 8. Poker Hand Testing\n";
-    cout << " 9. Pen-Based Recognition\n";
-    cout << "10. Contraceptive Method Choice (CMC)\n";
-    cout << "Enter dataset number (1-10): ";
+enum MiningMode { //Which frequent itemsets the miner reports
+    ALL_ITEMSETS,     //every frequent itemset
+    CLOSED_ITEMSETS,  //only itemsets without a superset of the same support (FPclose)
+    MAXIMAL_ITEMSETS  //only itemsets without a frequent superset (FPmax)
+};
 
-    int choice;
-    cin >> choice; //stores user input dataset number
+class ResultStore { //Closed or maximal itemsets found so far, for the subset checks of FPclose and FPmax
+                    //Maximal itemsets: every stack frame keeps the IDs of the stored itemsets that contain its
+                    //pattern, like the conditional MFI-trees of FPmax, so a check only scans results relevant
+                    //to the current branch.
+                    //Closed itemsets: only a stored itemset with the same support matters, so the store keeps a
+                    //list of itemsets per (item, support) pair and a check scans the shortest list of its items.
+public:
+    explicit ResultStore(bool bySupport) : bySupport(bySupport) {}
 
-    string inputFile; //string to store dataset filename
-    vector<string> attributeNames; // Vector to store the attribute names
-                                   // This is needed to ensure that features of different items do not get counted incorrectly
-    switch (choice) { //Case statement to determine which dataset and attributeName to load
-        case 1:
-            inputFile = "skin_segmentation.data";
-            attributeNames = {"B", "G", "R", "Y"};
-            break;
-        case 2:
-            inputFile = "adult.data";
-            attributeNames = {"age: ","workclass: ","fnlwgt: ","education: ","education-num: ","marital-status: ",
-                              "occupation: ","relationship: ","race: ","sex: ","capital-gain: ","capital-loss: ",
-                              "hours-per-week: ","native-country: ","income: "};
-            break;
-        case 3:
-            inputFile = "agaricus-lepiota.data";
-            attributeNames = {"poisonous", "cap-shape","cap-surface","cap-color","bruises","odor","gill-attachment",
-                              "gill-spacing","gill-size","gill-color","stalk-shape","stalk-root",
-                              "stalk-surface-above-ring","stalk-surface-below-ring","stalk-color-above-ring",
-                              "stalk-color-below-ring","veil-type","veil-color","ring-number","ring-type",
-                              "spore-print-color","population","habitat"};
-            break;
-        case 4:
-            inputFile = "car.data";
-            attributeNames = {"buying", "maint", "doors", "persons", "lug_boot", "safety", "class"};
-            break;
-        case 5:
-            inputFile = "nursery.data";
-            attributeNames = {"parents","has_nurs","form","children","housing", "finance","social","health","class"};
-            break;
-        case 6:
-            inputFile = "letter-recognition.data";
-            attributeNames = {"lettr", "x-box", "y-box","width","high","onpix","x-bar",
-                            "y-bar","x2bar","y2bar","xybar","x2ybr","xy2br","x-ege",
-                            "xegvy","y-ege","yegvx"};
-            break;
-        case 7:
-            inputFile = "kr-vs-kp.data";
-            attributeNames = {"bkblk","bknwy", "bkno8","bknoa","bkspr","bkxbq","bkxcr","bkxwp",
-                            "blxwp","bxqsq","cntxt","dsopp","dwipd","hdchk","katri","mulch",
-                            "qxmsq","r2ar8","reskd","reskr","rimmx","rkxwp","rxmsq","simpl",
-                            "skach","skewr","skrxp","spcop","stlmt","thrsk","wkcti","wkna8",
-                            "wknck","wkovl","wkpos","wtoeg"};
-            break;
-        case 8:
-            inputFile = "poker-hand-testing.dat";
-            attributeNames = { "S1", "C1", "S2", "C2", "S3", "C3", "S4", "C4", "S5", "C5", "CLASS"};
-            break;
-        case 9:
-            inputFile = "pen_based.data";
-            attributeNames = { "Attribute1", "Attribute2", "Attribute3", "Attribute4", "Attribute5", "Attribute6", "Attribute7", 
-            "Attribute8", "Attribute9", "Attribute10", "Attribute11", "Attribute12", "Attribute13", "Attribute14", "Attribute15",
-            "Attribute16", "Class"};
-            break;
-        case 10:
-            inputFile = "cmc.data";
-            attributeNames = { "wife_age", "wife_edu", "husband_edu", "num_children", "wife_religion", "wife_working", "husband_occupation",
-            "standard_of_living_index", "media_exposure", "contraceptive_method"};
-            break;
-        default:
-            cerr << "Invalid choice\n";
-            return 1;
+    int insert(const vector<int>& itemset, int support) { //store itemset (sorted by ID) and return its ID
+        int id = itemsets.size();
+        itemsets.push_back(itemset);
+        signatures.push_back(signatureOf(itemset));
+        if (bySupport)
+            for (int item : itemset)
+                postings[key(item, support)].push_back(id);
+        return id;
     }
 
-    int minSupport;
-    cout << "Enter minimum support: ";
-    cin >> minSupport; //Stores the minimum support entered by the user
-    ifstream fin(inputFile); //open the dataset file specified by the user (inputFile stores that data)
-        if (!fin.is_open()) {
-        cerr << "Cannot open file: " << inputFile << "\n";
-        return 1;
+    bool containsItem(int id, int item) const { //does stored itemset id contain item
+        return (signatures[id] >> (item & 63) & 1) && binary_search(itemsets[id].begin(), itemsets[id].end(), item);
     }
 
-    vector<vector<string>> transactions; //Vector to store all the transacations
-    string line;
-    while (getline(fin, line)) {
-        if (line.empty()) // If the line is empty, skip it
-        continue;
+    bool covered(const vector<int>& ids, const vector<int>& itemset) const {
+        // Function to check whether one of the stored itemsets in ids contains itemset (sorted by ID)
+        unsigned long long signature = signatureOf(itemset);
+        for (int id : ids)
+            if (contains(id, itemset, signature))
+                return true;
+        return false;
+    }
+
+    bool covered(const vector<int>& itemset, int support) const {
+        // Function to check whether a stored itemset with this support contains itemset (sorted by ID, not empty)
+        const vector<int>* shortest = nullptr;
+        for (int item : itemset) {
+            auto found = postings.find(key(item, support));
+            if (found == postings.end())
+                return false; //no stored itemset with this support contains the item
+            if (!shortest || found->second.size() < shortest->size())
+                shortest = &found->second;
+        }
+        return shortest && covered(*shortest, itemset);
+    }
 
-    for (char &c : line) { //Replace all commas with spaces
-                           //Part of the preprocessing done to ensure correct file reading
-        if (c == ',') c = ' ';
+private:
+    static unsigned long long signatureOf(const vector<int>& itemset) { //one bit per item (modulo 64), to rule out most candidates cheaply
+        unsigned long long signature = 0;
+        for (int item : itemset)
+            signature |= 1ULL << (item & 63);
+        return signature;
     }
 
-    vector<string> transaction; //Create an empty vector to stroe a single transacation
-    stringstream ss(line);  
-    string attributeValue; // represents a single value for one attribute in a transaction row
-    int index = 0; 
+    static unsigned long long key(int item, int support) { //postings key of an (item, support) pair
+        return ((unsigned long long)(unsigned)support << 32) | (unsigned)item;
+    }
+
+    bool contains(int id, const vector<int>& itemset, unsigned long long signature) const {
+        if (signature & ~signatures[id]) //a bit of itemset is missing, so an item is too
+            return false;
+        const vector<int>& stored = itemsets[id];
+        return stored.size() >= itemset.size() && includes(stored.begin(), stored.end(), itemset.begin(), itemset.end());
+    }
 
-    while (ss >> attributeValue) { //extract each attribute value from a dataset line and pair it with it's corresponding attirbute name from the variable - AttirbuteName
-        if (!attributeValue.empty() && attributeValue.back() == '\r') //check if string is not empty and if lsat character is carriage return 
-            attributeValue.pop_back(); //if both are true, remove that lhe last character
+    bool bySupport; //closed itemsets: index the itemsets by (item, support)
+    vector<vector<int>> itemsets; //stored itemsets, each sorted by ID
+    vector<unsigned long long> signatures; //bit signature of each stored itemset
+    unordered_map<unsigned long long, vector<int>> postings; //bySupport: the itemsets that contain each (item, support)
+};
 
-        if (!attributeValue.empty() && index < attributeNames.size()) //check if string is not empty and the current index of the vector is still within the bounds 
-            transaction.push_back(attributeNames[index] + ":" + attributeValue); //if both are true, pair the corresponding attirbute name with it's value from the dataset 
+struct MiningStats { //What the miners did, summed over every call and thread (for --stats)
+    atomic<long long> conditionalTrees{0}; //conditional trees built
+    atomic<long long> conditionalNodes{0}; //nodes of those trees
+    atomic<int> maxDepth{0}; //most conditional trees alive at once in one call
+    atomic<long long> partitions{0}; //partition trees built by the out-of-core miner
+    atomic<long long> largestTree{0}; //nodes of the largest of them
+    atomic<long long> intersections{0}; //bitset intersections done by the bitmap miner
 
-        index++; //advance to the next index
+    void add(long long trees, long long nodes, int depth) {
+        conditionalTrees += trees;
+        conditionalNodes += nodes;
+        raise(maxDepth, depth);
     }
 
-    if (!transaction.empty())
-        transactions.push_back(transaction); //store the processed dataset row into the list of all transacations
+    template <typename T>
+    static void raise(atomic<T>& maximum, T value) { //maximum = max(maximum, value), safe against other threads
+        T seen = maximum;
+        while (value > seen && !maximum.compare_exchange_weak(seen, value)) {}
     }
+} miningStats;
 
-    fin.close(); //close the input file 
+struct MiningFrame { //One level of the explicit mining stack
+    const HeaderTable* tree; //header table of the tree mined at this level
+    vector<pair<int, int>> items; //frequent items of that tree, in the order they are mined
+    size_t next; //index of the next item to mine
+    size_t patternStart; //size of the pattern before the items this tree is conditioned on were added
+    size_t pathStart; //size of the shared prefix-path item list before this frame added its own
+    vector<int> covering; //maximal mode: IDs of the results found so far that contain this frame's pattern
+    NodeArena arena; //arena of the conditional tree built for this level
+    HeaderTable header; //header table of that conditional tree
+};
 
-    auto startTime = high_resolution_clock::now(); //Start measuring execution time
+struct MiningContext { //What mineFPTree keeps from one call to the next, so a thread that mines many trees
+                       //reuses the frames, arenas and buffers of the last one instead of allocating them again
+    vector<unique_ptr<MiningFrame>> frames; //frames[d] mines the tree conditioned on d more items than the pattern
+    ConditionalScratch scratch; //buffers for buildConditionalTree
+};
+
+void splitPrefixPath(FPNode* root, HeaderTable& header, NodeArena& arena, vector<int>& pathItems, vector<int>& pathCounts) {
+    // Function to cut the single-path prefix off an FP-tree
+    // Every transaction of the tree runs through the nodes from the root down to the first node with more than one child.
+    // Those items are appended to pathItems (with their counts to pathCounts), removed from the header table,
+    // and the branching part below them is hung directly under the root. A single-path tree ends up empty.
+    FPNode* node = root;
+    while (node->firstChild && !node->firstChild->nextSibling) { //follow the chain while there is exactly one child
+        node = node->firstChild;
+        pathItems.push_back(node->item);
+        pathCounts.push_back(node->count);
+        header[node->item].clear(); //a path item cannot occur below the path, so this was its only node
+    }
+    if (node == root)
+        return;
+    root->firstChild = node->firstChild; //hang the branching part under the root
+    arena.moveChildren(node, root);
+    for (FPNode* child = root->firstChild; child; child = child->nextSibling)
+        child->parent = root;
+}
 
-    unordered_map<string, int> itemCount; //Hash table to store the item in the transacation and how many times it appears across all transacations
-                                          //Allows us to keep track of the frequency of each item in the dataset
-    for (const auto& transaction : transactions) //loop through each transactoin in all transactions
-        for (const auto& item : transaction)  //loop through each item in the current transaction
-            itemCount[item]++;                //count how many times each item appears in all transacations
-
-    vector<vector<string>> filteredTransactions; //Create a new vector called filteredTransactions (this will store the transacations that are below the threshold)
-    for (const auto& transaction : transactions) { //loop through each transaction in transacations
-        vector<string> filtered;  //For each transcation, create a temporary filtered vector
-        for (const auto& item : transaction) //loop through each item in the transaction 
-            if (itemCount[item] >= minSupport) //cehck if the frequency of the item is atleast minSupport (also known as the threshold)
-                filtered.push_back(item);  //If the frequency >= minSupport, add it to filtered
-        sort(filtered.begin(), filtered.end(), //Sort the filtered transacations in descending order of the respective frequencies
-             [&](const string& a, const string& b) {
-                 return itemCount[a] > itemCount[b];
-             });
-        if (!filtered.empty()) 
-            filteredTransactions.push_back(filtered); //Add the filtered transactions to the filteredTransactions vector
-    }
-
-    FPNode* root = new FPNode(); //Create an FP-tree root node 
-    map<string, vector<FPNode*>> headerTable; //Create a header table which stores pointers to all nodes of each item in the FP tree
-    for (const auto& transaction : filteredTransactions) //For each transactions in the filteredTransacation vector, insert it into the FP tree
-        insertTransaction(root, transaction, headerTable); 
-
-    cout << "\nConstructed FP-tree Structure:\n"; //Print FP-tree structure
-    printFPTree(root);
-
-    cout << "\nFrequent Itemsets Found:\n"; //Print the frequent itemsets found
-    mineFPTree(root, headerTable, minSupport);
+void mineFPTree(const HeaderTable& headerTable, int minSupport, ResultSink& out, vector<int> currentPattern = {},
+                const vector<pair<int, int>>* topItems = nullptr, MiningMode mode = ALL_ITEMSETS,
+                MiningContext* context = nullptr) { 
+    // Function to mine frequent patterns from the FP-tree
+    // context - memory kept across calls by a caller that mines many trees (nullptr: use a private one)
+    // headerTable - links each item ID to all its nodes in the FP tree
+    // minSupport - the minimum frequency an itemset must have to be considered frequent (also known as the threshold)
+    // out - sink that receives the frequent itemsets
+    // currentPattern - the frequent itemset the tree is conditioned on
+    // topItems - if given, only these (item, support) entries of headerTable are mined, e.g. one task of the parallel miner
+    // mode - report all, closed or maximal itemsets
+    // FP-growth recurses once per pattern item; this driver keeps that recursion on an explicit stack of frames.
+    // Only one conditional tree per level is alive at a time and frames are reused as the depth goes up and down,
+    // so memory grows with the pattern length and not with the number of patterns.
+    // When a conditional tree starts with a single path, the patterns made of path items are listed directly
+    // as combinations of the path nodes, and only the branching part below the path is mined further.
+    //
+    // Closed and maximal modes follow FPclose and FPmax. Items are mined in the reverse of their order along the
+    // tree paths, so an itemset can only be contained in itemsets that were found before it. Before descending into
+    // a conditional tree, the largest result it could still produce (its closure, or for maximal mode the head plus
+    // every frequent item of the tree) is looked up in the index of results found so far. If a stored itemset
+    // covers it, the whole branch is skipped. Otherwise every closed/maximal itemset below contains the prefix path
+    // of the tree, so the path items are simply added to the pattern instead of being combined.
+    //
+    // In all-itemsets mode the order does not matter, so each tree is mined from its most frequent item down.
+    // The threshold of the sink (see ResultSink::threshold) then rises as fast as possible, and once an item is
+    // below it the rest of the tree is too.
 
-    cout << "\nTotal Frequent Itemsets Found: " << totalFrequentItemsets << "\n"; //Print the total number of frequent itemsets found
+    vector<int> pathItems; //items of the single-path prefixes cut off the trees on the stack
+    vector<int> pathCounts; //count of each node in pathItems
+    MiningContext ownContext;
+    if (!context)
+        context = &ownContext;
+    vector<unique_ptr<MiningFrame>>& frames = context->frames;
+    ConditionalScratch& scratch = context->scratch;
+    long long nodesBefore = 0; //nodes the reused arenas had already created before this call
+    for (auto& frame : frames)
+        nodesBefore += frame->arena.nodesCreated();
+    auto emit = [&](int support) { //output currentPattern together with every subset of the cut-off path items:
+                                   //every transaction below a prefix path contains all of its items, so the support is the same
+        forEachSubset(pathItems, pathItems.size(), currentPattern, [&]() { out.add(currentPattern, support); });
+    };
 
-    deleteFPTree(root); //delete FP-tree from memory 
+    ResultStore results(mode == CLOSED_ITEMSETS); //closed or maximal itemsets reported so far
+    vector<int> candidate; //scratch itemset for the closed and maximal checks
+    size_t depth = 1; //number of frames in use
+    long long treesBuilt = 0; //conditional trees built, for miningStats
+    auto covered = [&](const vector<int>& covering, int support) { //is candidate (sorted) covered by a result found so far
+        return mode == CLOSED_ITEMSETS ? results.covered(candidate, support) : results.covered(covering, candidate);
+    };
+    auto report = [&](int support) { //report candidate (sorted) as a result; it contains the pattern of every frame up to depth
+        int id = results.insert(candidate, support);
+        out.add(candidate, support);
+        if (mode == MAXIMAL_ITEMSETS)
+            for (size_t d = 0; d <= depth; d++)
+                frames[d]->covering.push_back(id);
+    };
 
-    auto endTime = high_resolution_clock::now(); //Record the endtime
-    duration<double> elapsedSeconds = endTime - startTime; //compute the elapsed time since StartTime - gives us how long the algorithm took to run
-    cout << "\nAlgorithm finished in " << elapsedSeconds.count() << " seconds.\n"; //Print how long the alogrithm took to run
+    if (frames.empty())
+        frames.emplace_back(new MiningFrame());
+    frames[0]->tree = &headerTable;
+    frames[0]->items = topItems ? *topItems : frequentItems(headerTable, max(minSupport, out.threshold()));
+    if (mode == ALL_ITEMSETS)
+        reverse(frames[0]->items.begin(), frames[0]->items.end());
+    else //the paths of the top-level tree are in ID order, which a tree updated with --load-tree no longer ranks by support
+        sort(frames[0]->items.begin(), frames[0]->items.end(), [](auto& a, auto& b) { return a.first > b.first; });
+    frames[0]->next = 0;
+    frames[0]->patternStart = currentPattern.size();
+    frames[0]->pathStart = 0;
+    frames[0]->covering.clear();
 
-    return 0;
-}
\ No newline at end of file
+    while (depth > 0) {
+        MiningFrame& frame = *frames[depth - 1];
+        int threshold = max(minSupport, out.threshold()); //support the sink still wants
+        if (mode == ALL_ITEMSETS && frame.next < frame.items.size() && frame.items[frame.next].second < threshold)
+            frame.next = frame.items.size(); //the items left are even less frequent
+        if (frame.next == frame.items.size()) { //every item of this tree is done, go back up one level
+            pathItems.resize(frame.pathStart); //the prefix path of this tree no longer applies
+            pathCounts.resize(frame.pathStart);
+            currentPattern.resize(frame.patternStart); //drop the items this frame was conditioned on
+            depth--;
+            continue;
+        }
+
+        int item = frame.items[frame.next].first; // the next frequent item of this tree
+        int support = frame.items[frame.next].second; // and its frequency
+        frame.next++;
+
+        size_t patternStart = currentPattern.size();
+        currentPattern.push_back(item); // add the current item to the pattern
+        if (mode == ALL_ITEMSETS)
+            emit(support); // output the current frequent pattern
+
+        if (depth == frames.size()) //first time this deep, add a frame
+            frames.emplace_back(new MiningFrame());
+        MiningFrame& child = *frames[depth];
+        child.arena.reset(); //the tree this frame held before is finished
+
+        FPNode* conditionalRoot = buildConditionalTree(*frame.tree, item, threshold, child.arena, child.header, scratch);
+        if (conditionalRoot)
+            treesBuilt++;
+        if (mode == ALL_ITEMSETS && !conditionalRoot) {
+            currentPattern.pop_back(); //nothing more to grow from this item
+            continue;
+        }
+
+        if (mode != ALL_ITEMSETS) {
+            child.covering.clear(); //the results that can cover this branch contain the item as well
+            if (mode == MAXIMAL_ITEMSETS)
+                for (int id : frame.covering)
+                    if (results.containsItem(id, item))
+                        child.covering.push_back(id);
+
+            vector<pair<int, int>> tail; //frequent items of the conditional tree
+            if (conditionalRoot)
+                tail = frequentItems(child.header, minSupport);
+
+            candidate = currentPattern; //the largest result this branch could still produce
+            for (auto& entry : tail)
+                if (mode == MAXIMAL_ITEMSETS || entry.second == support) //closure: items in every transaction of the head
+                    candidate.push_back(entry.first);
+            sort(candidate.begin(), candidate.end());
+            bool prune = covered(child.covering, support);
+            if (!prune && (mode == CLOSED_ITEMSETS || tail.empty())) //the closure is closed, or a head without
+                report(support);                                      //frequent extensions is maximal
+            if (prune || tail.empty()) {
+                currentPattern.pop_back();
+                continue;
+            }
+
+            vector<int> newPath, newCounts; //prefix path of the conditional tree
+            splitPrefixPath(conditionalRoot, child.header, child.arena, newPath, newCounts);
+            if (mode == CLOSED_ITEMSETS) { //path prefixes where the count drops are closed as well
+                for (size_t i = 0; i < newPath.size(); i++) {
+                    if (newCounts[i] == support || (i + 1 < newPath.size() && newCounts[i + 1] == newCounts[i]))
+                        continue;
+                    candidate = currentPattern;
+                    candidate.insert(candidate.end(), newPath.begin(), newPath.begin() + i + 1);
+                    sort(candidate.begin(), candidate.end());
+                    if (!covered(child.covering, newCounts[i]))
+                        report(newCounts[i]);
+                }
+            }
+            currentPattern.insert(currentPattern.end(), newPath.begin(), newPath.end()); //every result below contains the path
+
+            child.items.clear(); //the branching part below the path is mined further
+            for (auto& entry : tail)
+                if (!child.header[entry.first].empty())
+                    child.items.push_back(entry);
+            if (child.items.empty()) { //single path: head plus path is the only maximal candidate
+                if (mode == MAXIMAL_ITEMSETS) { //already checked above: it is the head plus every frequent item
+                    candidate = currentPattern;
+                    sort(candidate.begin(), candidate.end());
+                    report(newCounts.back());
+                }
+                currentPattern.resize(patternStart);
+                continue;
+            }
+            child.pathStart = pathItems.size();
+        } else {
+            child.pathStart = pathItems.size();
+            splitPrefixPath(conditionalRoot, child.header, child.arena, pathItems, pathCounts);
+            for (size_t i = child.pathStart; i < pathItems.size(); i++) { //patterns made only of new path items:
+                currentPattern.push_back(pathItems[i]); //the deepest chosen node is i, so the support is its count
+                forEachSubset(pathItems, i, currentPattern, [&]() { out.add(currentPattern, pathCounts[i]); }); //the others come from above it
+                currentPattern.pop_back();
+            }
+            child.items = frequentItems(child.header, threshold);
+            reverse(child.items.begin(), child.items.end());
+        }
+
+        child.tree = &child.header; //descend into the branching part of the conditional tree
+        child.next = 0;
+        child.patternStart = patternStart;
+        depth++;
+    }
+
+    long long nodesBuilt = -nodesBefore; //nodes of every conditional tree, roots included (frame 0 mines the given tree and builds none)
+    for (auto& frame : frames)
+        nodesBuilt += frame->arena.nodesCreated();
+    miningStats.add(treesBuilt, nodesBuilt, frames.size() - 1);
+}
+
+class WorkStealingQueue { //Per-worker task queues for the parallel miner
+                          //A worker takes tasks from the front of its own queue and, once that is empty,
+                          //steals from the back of the other queues so no thread sits idle behind a large task
+public:
+    explicit WorkStealingQueue(int numWorkers) : queues(numWorkers), locks(numWorkers) {}
+
+    void push(int worker, int task) {
+        lock_guard<mutex> lock(locks[worker]);
+        queues[worker].push_back(task);
+    }
+
+    bool pop(int worker, int& task) { //get the next task for worker; false once every queue is empty
+        int numWorkers = queues.size();
+        for (int i = 0; i < numWorkers; i++) {
+            int victim = (worker + i) % numWorkers; //start with our own queue
+            lock_guard<mutex> lock(locks[victim]);
+            if (queues[victim].empty())
+                continue;
+            if (victim == worker) {
+                task = queues[victim].front();
+                queues[victim].pop_front();
+            } else {
+                task = queues[victim].back();
+                queues[victim].pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    vector<deque<int>> queues; //tasks waiting for each worker
+    vector<mutex> locks; //one lock per queue
+};
+
+void mineFPTreeParallel(const HeaderTable& headerTable, int minSupport, vector<ResultSink*>& sinks) {
+    // Function to mine the FP-tree with one thread per sink
+    // Each frequent item of the top-level header table is one task: its conditional pattern base and conditional tree
+    // only read the shared tree, so the tasks are independent.
+    int numThreads = sinks.size();
+    vector<pair<int, int>> items = frequentItems(headerTable, minSupport);
+
+    vector<int> order(items.size()); // hand out the most expensive tasks first so big conditional trees do not start last
+    for (int i = 0; i < (int)order.size(); i++)
+        order[i] = i;
+    auto cost = [&](int task) { // nodes of the item times their depth bound (a larger ID sits deeper in the tree)
+        return (long long)headerTable[items[task].first].size() * (items[task].first + 1);
+    };
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return cost(a) > cost(b); });
+
+    WorkStealingQueue queue(numThreads);
+    for (int i = 0; i < (int)order.size(); i++) // deal the tasks out round-robin
+        queue.push(i % numThreads, order[i]);
+
+    vector<thread> workers;
+    for (int w = 0; w < numThreads; w++) {
+        workers.emplace_back([&, w]() {
+            vector<pair<int, int>> taskItems(1); // the one top-level item this task mines
+            MiningContext context; // frames and buffers this worker reuses from task to task
+            int task;
+            while (queue.pop(w, task)) {
+                taskItems[0] = items[task];
+                mineFPTree(headerTable, minSupport, *sinks[w], {}, &taskItems, ALL_ITEMSETS, &context);
+            }
+            sinks[w]->flush();
+        });
+    }
+    for (thread& worker : workers)
+        worker.join();
+}
+
+struct VerticalDatabase { //The transactions turned on their side for the bitmap miner
+                          //Each frequent item has a bitset over the transactions, with bit t set when transaction t holds it
+    size_t words = 0; //64-bit words per bitset
+    vector<int> supports; //support of each item ID (the bits set in its bitset)
+    vector<uint64_t> bits; //bitset of item i is bits[i * words] .. bits[(i + 1) * words - 1]
+
+    void resize(int numItems, size_t numTransactions) {
+        words = (numTransactions + 63) / 64;
+        supports.assign(numItems, 0);
+        bits.assign(numItems * words, 0);
+    }
+
+    void add(int item, size_t transaction) { //transaction holds item
+        bits[item * words + transaction / 64] |= 1ULL << (transaction % 64);
+        supports[item]++;
+    }
+
+    const uint64_t* of(int item) const { return bits.data() + item * words; } //bitset of item
+
+    static constexpr double MIN_DENSITY = 0.02; //--engine auto: share of the bits that must be set to prefer the bitsets
+    static const size_t MAX_BYTES = (size_t)1 << 28; //--engine auto: largest size of the bitsets and the first frame
+                                                     //of every mining thread, which can hold nearly all of them
+};
+
+using IntersectFunction = int (*)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words);
+
+int intersectScalar(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words) {
+    // Function to AND two bitsets into out and count the bits set in the result, i.e. the support of the joined itemset
+    long long count = 0;
+    for (size_t i = 0; i < words; i++) {
+        out[i] = a[i] & b[i];
+        count += __builtin_popcountll(out[i]);
+    }
+    return count;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+__attribute__((target("popcnt"))) int intersectPopcnt(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words) {
+    // Function to intersect two bitsets like intersectScalar, with the popcount instruction
+    long long count = 0;
+    for (size_t i = 0; i < words; i++) {
+        out[i] = a[i] & b[i];
+        count += __builtin_popcountll(out[i]);
+    }
+    return count;
+}
+
+__attribute__((target("avx2,popcnt"))) int intersectAvx2(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words) {
+    // Function to intersect two bitsets like intersectScalar, four words per step
+    // The bits of each byte are counted with a nibble lookup table (vpshufb) and summed per word with vpsadbw,
+    // so the count stays in a vector register until the end.
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4); //bits set in each nibble value
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+    __m256i counts = _mm256_setzero_si256(); //bits counted so far, one sum per word lane
+    size_t i = 0;
+    for (; i + 4 <= words; i += 4) {
+        __m256i both = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+        _mm256_storeu_si256((__m256i*)(out + i), both);
+        __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(both, lowNibbles));
+        __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(both, 4), lowNibbles));
+        counts = _mm256_add_epi64(counts, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+    long long count = _mm256_extract_epi64(counts, 0) + _mm256_extract_epi64(counts, 1) + _mm256_extract_epi64(counts, 2) +
+                      _mm256_extract_epi64(counts, 3);
+    for (; i < words; i++) { //the words left over
+        out[i] = a[i] & b[i];
+        count += __builtin_popcountll(out[i]);
+    }
+    return count;
+}
+#endif
+
+IntersectFunction chooseIntersect() {
+    // Function to pick the fastest bitset intersection the CPU supports, so a plain -O2 build still uses SIMD
+    // (without -march=native, __builtin_popcountll alone is a library call)
+#if defined(__GNUC__) && defined(__x86_64__)
+    __builtin_cpu_init(); //runs before main, so the CPU has not been identified yet
+    if (__builtin_cpu_supports("avx2"))
+        return intersectAvx2;
+    if (__builtin_cpu_supports("popcnt"))
+        return intersectPopcnt;
+#endif
+    return intersectScalar;
+}
+
+const IntersectFunction intersect = chooseIntersect(); //the intersection the bitmap miner uses
+
+struct BitmapFrame { //One level of the bitmap miner's stack: the frequent extensions of one itemset
+    vector<int> items; //item each extension adds, in the order of bitmapOrder
+    vector<int> supports; //support of the itemset with each extension
+    vector<uint64_t> bits; //transactions of the itemset with each extension, one bitset after another
+    size_t left; //extensions not mined yet; they are mined from the last one back
+};
+
+struct BitmapContext { //What mineBitmap keeps from one call to the next, so a thread that mines many first items
+                       //reuses the frames of the last one instead of allocating and clearing them again
+    vector<unique_ptr<BitmapFrame>> frames; //frames[d] holds the extensions of the current itemset of d + 1 items
+};
+
+vector<int> bitmapOrder(const VerticalDatabase& vertical, int minSupport) {
+    // Function to list the frequent items in the order the bitmap miner extends itemsets with them: least frequent first,
+    // so the early itemsets, which have the most extensions, have the fewest transactions
+    vector<int> order;
+    for (int item = 0; item < (int)vertical.supports.size(); item++)
+        if (vertical.supports[item] >= minSupport)
+            order.push_back(item);
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { return vertical.supports[a] < vertical.supports[b]; });
+    return order;
+}
+
+void mineBitmap(const VerticalDatabase& vertical, const vector<int>& order, size_t first, size_t last, int minSupport,
+                ResultSink& out, BitmapContext& context) {
+    // Function to mine frequent patterns from the item bitsets (Eclat on a vertical layout)
+    // order - the frequent items in mining order (see bitmapOrder)
+    // first, last - only the itemsets whose first item is order[first] .. order[last - 1] are mined
+    // An itemset is only extended with items after its own in the order, so every itemset is found once.
+    // The transactions of P+a+b are those of P+a AND those of P+b, so each frame keeps the bitsets of the frequent
+    // extensions of its itemset, and the frame above it is made by ANDing one of them with each one after it.
+    // Like mineFPTree, the recursion runs on an explicit stack of reused frames, and the itemsets are grown from the most
+    // frequent items down (the end of the order first), so the threshold of the sink rises early in top-k mode; it is
+    // checked before every extension. The same itemsets with the same supports come out as from the FP-tree.
+    // context - frames left by an earlier call of this thread
+    size_t words = vertical.words;
+    vector<unique_ptr<BitmapFrame>>& frames = context.frames;
+    vector<int> pattern; //the current itemset
+    long long intersections = 0; //bitset intersections done, for miningStats
+
+    auto extend = [&](size_t d, const uint64_t* base, size_t numCandidates, auto candidate) {
+        // fill frames[d] with the frequent ones among numCandidates extensions; candidate(c) gives the item and
+        // bitset of extension c, and base is the bitset of the itemset being extended
+        if (d == frames.size()) //first time this deep, add a frame
+            frames.emplace_back(new BitmapFrame());
+        BitmapFrame& frame = *frames[d];
+        frame.items.clear();
+        frame.supports.clear();
+        if (frame.bits.size() < numCandidates * words)
+            frame.bits.resize(numCandidates * words);
+        int threshold = max(minSupport, out.threshold());
+        for (size_t c = 0; c < numCandidates; c++) {
+            pair<int, const uint64_t*> extension = candidate(c);
+            int support = intersect(base, extension.second, frame.bits.data() + frame.items.size() * words, words);
+            if (support >= threshold) { //keep its bitset, otherwise the next one overwrites it
+                frame.items.push_back(extension.first);
+                frame.supports.push_back(support);
+            }
+        }
+        intersections += numCandidates;
+        frame.left = frame.items.size();
+        return frame.left > 0;
+    };
+
+    for (size_t i = last; i-- > first;) {
+        int item = order[i];
+        if (vertical.supports[item] < max(minSupport, out.threshold()))
+            continue;
+        pattern.assign(1, item);
+        out.add(pattern, vertical.supports[item]);
+
+        size_t depth = extend(0, vertical.of(item), order.size() - i - 1, [&](size_t c) {
+            return make_pair(order[i + 1 + c], vertical.of(order[i + 1 + c]));
+        }) ? 1 : 0; //number of frames in use
+        while (depth > 0) {
+            BitmapFrame& frame = *frames[depth - 1];
+            if (frame.left == 0) { //every extension is done, go back up one level
+                pattern.pop_back(); //drop the item this frame extended
+                depth--;
+                continue;
+            }
+            size_t k = --frame.left;
+            if (frame.supports[k] < max(minSupport, out.threshold())) //the threshold of the sink rose since
+                continue;
+            pattern.push_back(frame.items[k]);
+            out.add(pattern, frame.supports[k]);
+
+            const uint64_t* base = frame.bits.data() + k * words;
+            if (extend(depth, base, frame.items.size() - k - 1, [&](size_t c) {
+                    return make_pair(frame.items[k + 1 + c], (const uint64_t*)frame.bits.data() + (k + 1 + c) * words);
+                }))
+                depth++;
+            else
+                pattern.pop_back(); //nothing more to grow from this itemset
+        }
+    }
+    miningStats.intersections += intersections;
+}
+
+void mineBitmapParallel(const VerticalDatabase& vertical, int minSupport, vector<ResultSink*>& sinks) {
+    // Function to mine the item bitsets with one thread per sink
+    // Each first item is one task. The bitsets are only read, so the tasks are independent. Tasks are small and taken
+    // from a shared counter as threads get free, from the most frequent item down like mineBitmap does.
+    // Each thread keeps one set of frames for all of its tasks.
+    vector<int> order = bitmapOrder(vertical, minSupport);
+    atomic<size_t> nextTask(0); //tasks handed out so far
+    vector<thread> workers;
+    for (size_t w = 0; w < sinks.size(); w++) {
+        workers.emplace_back([&, w]() {
+            BitmapContext context;
+            for (size_t task = nextTask++; task < order.size(); task = nextTask++)
+                mineBitmap(vertical, order, order.size() - 1 - task, order.size() - task, minSupport, *sinks[w], context);
+            sinks[w]->flush();
+        });
+    }
+    for (thread& worker : workers)
+        worker.join();
+}
+
+class ItemsetStore : public ResultSink { //Keeps every itemset it receives, so rules can be derived from them afterwards
+public:
+    void add(const vector<int>& itemset, int support) override {
+        size_t start = items.size();
+        items.insert(items.end(), itemset.begin(), itemset.end());
+        sort(items.begin() + start, items.end()); //stored by ascending ID, the order ItemsetTrie needs
+        starts.push_back(items.size());
+        supports.push_back(support);
+        count++;
+    }
+
+    size_t size() const { return supports.size(); } //number of itemsets stored
+    const int* begin(size_t i) const { return items.data() + starts[i]; } //first item of itemset i
+    size_t length(size_t i) const { return starts[i + 1] - starts[i]; } //number of items of itemset i
+
+    vector<int> items; //item IDs of every itemset, one after another
+    vector<size_t> starts = {0}; //itemset i is items[starts[i] .. starts[i + 1])
+    vector<int> supports; //support of each itemset
+};
+
+class ItemsetTrie { //Support lookup for the itemsets of a set of stores
+                    //Nodes are laid out level by level and the children of a node are contiguous and sorted by item,
+                    //so looking up an itemset is one binary search per item.
+public:
+    ItemsetTrie(const vector<ItemsetStore*>& stores, size_t numTransactions) : numTransactions(numTransactions) {
+        vector<pair<const ItemsetStore*, size_t>> order; //every itemset, by length and then lexicographically
+        for (const ItemsetStore* store : stores)
+            for (size_t i = 0; i < store->size(); i++)
+                order.push_back({store, i});
+        auto less = [](const pair<const ItemsetStore*, size_t>& a, const pair<const ItemsetStore*, size_t>& b) {
+            size_t lengthA = a.first->length(a.second), lengthB = b.first->length(b.second);
+            if (lengthA != lengthB)
+                return lengthA < lengthB;
+            const int* x = a.first->begin(a.second);
+            return lexicographical_compare(x, x + lengthA, b.first->begin(b.second), b.first->begin(b.second) + lengthB);
+        };
+        sort(order.begin(), order.end(), less);
+
+        nodes.push_back({-1, 0, 1, 0}); //the root stands for the empty itemset; its support is numTransactions
+        vector<size_t> source = {0}; //position in order of the itemset each node stands for (none for the root)
+        size_t parentLevel = 0, level = 0; //first node of the previous and of the current level
+        size_t parentLength = 0, currentLength = 0; //itemset length of the previous and of the current level
+        size_t parent = 0; //parent candidate for the next itemset; the prefixes of sorted itemsets come in sorted order
+        auto itemsOf = [&](size_t node) { return order[source[node]].first->begin(order[source[node]].second); };
+        for (size_t k = 0; k < order.size(); k++) {
+            const ItemsetStore* store = order[k].first;
+            size_t length = store->length(order[k].second);
+            const int* itemset = store->begin(order[k].second);
+            if (length != currentLength) { //first itemset of a new level
+                parentLevel = level;
+                parentLength = currentLength;
+                level = nodes.size();
+                currentLength = length;
+                parent = parentLevel;
+            }
+            if (length == 0 || parentLength != length - 1)
+                continue; //no stored prefixes to hang it under
+            if (length > 1) { //find the node of the itemset without its last item
+                while (parent < level && lexicographical_compare(itemsOf(parent), itemsOf(parent) + length - 1,
+                                                                 itemset, itemset + length - 1))
+                    parent++;
+                if (parent == level || !equal(itemset, itemset + length - 1, itemsOf(parent)))
+                    continue; //the prefix is not stored, so this itemset cannot be either
+            }
+            if (nodes[parent].numChildren == 0)
+                nodes[parent].firstChild = nodes.size();
+            nodes[parent].numChildren++;
+            nodes.push_back({itemset[length - 1], store->supports[order[k].second], 0, 0});
+            source.push_back(k);
+        }
+    }
+
+    long long support(const vector<int>& itemset) const { //support of a sorted itemset; 0 if it is not stored
+        int node = 0;
+        for (int item : itemset) {
+            auto first = nodes.begin() + nodes[node].firstChild;
+            auto last = first + nodes[node].numChildren;
+            auto it = lower_bound(first, last, item, [](const Node& n, int item) { return n.item < item; });
+            if (it == last || it->item != item)
+                return 0;
+            node = it - nodes.begin();
+        }
+        return node == 0 ? (long long)numTransactions : nodes[node].support;
+    }
+
+private:
+    struct Node {
+        int item; //last item of the itemset this node stands for
+        int support; //support of that itemset
+        int firstChild; //index of the first child node
+        int numChildren; //number of children
+    };
+    vector<Node> nodes; //nodes[0] is the root
+    size_t numTransactions; //support of the empty itemset
+};
+
+long long generateRules(const vector<ItemsetStore*>& stores, const ItemsetTrie& trie, size_t numTransactions,
+                        double minConfidence, double minLift, int numThreads, ostream* os) {
+    // Function to derive the association rules A => C from the stored itemsets, where A and C split an itemset
+    // Only rules with confidence support(A u C) / support(A) >= minConfidence and
+    // lift confidence / (support(C) / numTransactions) >= minLift are reported.
+    // The consequents of an itemset are grown one item at a time: moving an item from A to C can only lower the
+    // confidence, so a consequent is only extended while its rule is confident enough.
+    // Itemsets are handed out to the threads in chunks; each thread formats its rules into its own buffer.
+    // os - stream that receives the rules as text, or nullptr to only count them
+    // Returns the number of rules reported.
+    vector<pair<const ItemsetStore*, size_t>> work; //every itemset with at least two items
+    for (const ItemsetStore* store : stores)
+        for (size_t i = 0; i < store->size(); i++)
+            if (store->length(i) >= 2)
+                work.push_back({store, i});
+
+    const size_t CHUNK = 256; //itemsets a thread takes at once
+    const size_t FLUSH_SIZE = 1 << 16; //buffer size that triggers a write
+    atomic<size_t> nextChunk(0);
+    atomic<long long> total(0);
+
+    auto worker = [&]() {
+        string text; //formatted rules that have not been written yet
+        long long found = 0;
+        vector<int> itemset, antecedent, consequent; //the itemset and the two sides of the current rule
+        vector<int> current, next; //consequents of the current and of the next size, as positions in itemset
+        char number[64];
+
+        auto write = [&](int support, double confidence, double lift) {
+            found++;
+            if (!os)
+                return;
+            text += "{ ";
+            for (int id : antecedent) {
+                text += cleanItem(dictionary.names[id]);
+                text += ' ';
+            }
+            text += "} => { ";
+            for (int id : consequent) {
+                text += cleanItem(dictionary.names[id]);
+                text += ' ';
+            }
+            snprintf(number, sizeof(number), "} : %d, confidence %.4f, lift %.4f\n", support, confidence, lift);
+            text += number;
+            if (text.size() >= FLUSH_SIZE) {
+                lock_guard<mutex> lock(outputMutex);
+                os->write(text.data(), text.size());
+                text.clear();
+            }
+        };
+        auto tryRule = [&](const int* positions, size_t size, int support) { //rule with the given consequent positions;
+                                                                             //true if it is confident enough to extend
+            antecedent.clear();
+            consequent.clear();
+            size_t p = 0;
+            for (size_t i = 0; i < itemset.size(); i++) {
+                if (p < size && positions[p] == (int)i) {
+                    consequent.push_back(itemset[i]);
+                    p++;
+                } else {
+                    antecedent.push_back(itemset[i]);
+                }
+            }
+            long long antecedentSupport = trie.support(antecedent);
+            long long consequentSupport = trie.support(consequent);
+            if (!antecedentSupport || !consequentSupport) //a side that was not mined (cannot happen for all itemsets)
+                return false;
+            double confidence = (double)support / antecedentSupport;
+            if (confidence < minConfidence)
+                return false;
+            double lift = confidence * (double)numTransactions / consequentSupport;
+            if (lift >= minLift)
+                write(support, confidence, lift);
+            return true;
+        };
+
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(CHUNK)) < work.size()) {
+            for (size_t w = chunk; w < min(chunk + CHUNK, work.size()); w++) {
+                const ItemsetStore* store = work[w].first;
+                itemset.assign(store->begin(work[w].second), store->begin(work[w].second) + store->length(work[w].second));
+                int support = store->supports[work[w].second];
+
+                current.clear(); //single-item consequents
+                for (int i = 0; i < (int)itemset.size(); i++)
+                    if (tryRule(&i, 1, support))
+                        current.push_back(i);
+                for (size_t size = 1; size + 1 < itemset.size() && current.size() >= 2 * size; size++) {
+                    next.clear(); //join consequents that differ only in their last position
+                    for (size_t a = 0; a < current.size(); a += size) {
+                        for (size_t b = a + size; b < current.size(); b += size) {
+                            if (!equal(&current[a], &current[a] + size - 1, &current[b]))
+                                break; //consequents are sorted, so no later one shares the prefix either
+                            size_t start = next.size();
+                            next.insert(next.end(), &current[a], &current[a] + size);
+                            next.push_back(current[b + size - 1]);
+                            if (!tryRule(&next[start], size + 1, support))
+                                next.resize(start);
+                        }
+                    }
+                    swap(current, next);
+                }
+            }
+        }
+        if (os && !text.empty()) {
+            lock_guard<mutex> lock(outputMutex);
+            os->write(text.data(), text.size());
+        }
+        total += found;
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < numThreads; t++)
+        workers.emplace_back(worker);
+    worker(); //the calling thread works as well
+    for (thread& w : workers)
+        w.join();
+    return total;
+}
+
+struct KnownDataset { //A UCI dataset the program knows the file and attribute names of
+    const char* title; //name shown in the usage text
+    const char* inputFile; //default file name of the dataset
+    vector<string> attributeNames; //names of its columns, in file order
+                                   //This is needed to ensure that features of different items do not get counted incorrectly
+};
+
+const vector<KnownDataset> knownDatasets = {
+    {"Skin Segmentation", "skin_segmentation.data", {"B", "G", "R", "Y"}},
+    {"Adult", "adult.data",
+     {"age: ","workclass: ","fnlwgt: ","education: ","education-num: ","marital-status: ",
+      "occupation: ","relationship: ","race: ","sex: ","capital-gain: ","capital-loss: ",
+      "hours-per-week: ","native-country: ","income: "}},
+    {"Agaricus-Lepiota (Mushroom)", "agaricus-lepiota.data",
+     {"poisonous", "cap-shape","cap-surface","cap-color","bruises","odor","gill-attachment",
+      "gill-spacing","gill-size","gill-color","stalk-shape","stalk-root",
+      "stalk-surface-above-ring","stalk-surface-below-ring","stalk-color-above-ring",
+      "stalk-color-below-ring","veil-type","veil-color","ring-number","ring-type",
+      "spore-print-color","population","habitat"}},
+    {"Car Evaluation", "car.data", {"buying", "maint", "doors", "persons", "lug_boot", "safety", "class"}},
+    {"Nursery", "nursery.data", {"parents","has_nurs","form","children","housing", "finance","social","health","class"}},
+    {"Letter Recognition", "letter-recognition.data",
+     {"lettr", "x-box", "y-box","width","high","onpix","x-bar",
+      "y-bar","x2bar","y2bar","xybar","x2ybr","xy2br","x-ege",
+      "xegvy","y-ege","yegvx"}},
+    {"King-Rook vs King-Pawn (Chess)", "kr-vs-kp.data",
+     {"bkblk","bknwy", "bkno8","bknoa","bkspr","bkxbq","bkxcr","bkxwp",
+      "blxwp","bxqsq","cntxt","dsopp","dwipd","hdchk","katri","mulch",
+      "qxmsq","r2ar8","reskd","reskr","rimmx","rkxwp","rxmsq","simpl",
+      "skach","skewr","skrxp","spcop","stlmt","thrsk","wkcti","wkna8",
+      "wknck","wkovl","wkpos","wtoeg"}},
+    {"Poker Hand Testing", "poker-hand-testing.dat", { "S1", "C1", "S2", "C2", "S3", "C3", "S4", "C4", "S5", "C5", "CLASS"}},
+    {"Pen-Based Recognition", "pen_based.data",
+     { "Attribute1", "Attribute2", "Attribute3", "Attribute4", "Attribute5", "Attribute6", "Attribute7", 
+       "Attribute8", "Attribute9", "Attribute10", "Attribute11", "Attribute12", "Attribute13", "Attribute14", "Attribute15",
+       "Attribute16", "Class"}},
+    {"Contraceptive Method Choice (CMC)", "cmc.data",
+     { "wife_age", "wife_edu", "husband_edu", "num_children", "wife_religion", "wife_working", "husband_occupation",
+       "standard_of_living_index", "media_exposure", "contraceptive_method"}},
+};
+
+struct TransactionDatabase { //Every transaction of a dataset as item IDs, stored back to back in one array
+    vector<int> items; //item IDs of all transactions, one transaction after another
+    vector<size_t> starts = {0}; //transaction t is items[starts[t]] .. items[starts[t + 1] - 1]
+
+    size_t size() const { return starts.size() - 1; } //number of transactions
+};
+
+class MappedFile { //Read-only memory mapping of a whole file
+                   //The loader tokenizes the mapped bytes in place, so the raw text is never copied into strings
+public:
+    MappedFile() : data(nullptr), size(0) {}
+    ~MappedFile() {
+        if (data)
+            munmap((void*)data, size);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const string& path) { //map the file; false if it cannot be opened
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        size = info.st_size;
+        if (size > 0) { //an empty file has nothing to map
+            void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                return false;
+            }
+            madvise(mapping, size, MADV_SEQUENTIAL); //the file is read once from front to back
+            data = (const char*)mapping;
+        }
+        close(fd);
+        return true;
+    }
+
+    const char* data; //first byte of the file
+    size_t size; //number of bytes in the file
+};
+
+template <typename Callback>
+void forEachField(const char* begin, const char* end, char delimiter, Callback field) {
+    // Function to split one line into fields and call field(column, value, length) for each non-empty one
+    // delimiter 0 - fields are separated by runs of commas and whitespace, so columns never hold empty fields
+    // any other delimiter - every delimiter starts a new column, and spaces around a value are trimmed
+    int column = 0;
+    const char* p = begin;
+    if (delimiter == 0) {
+        auto separator = [](char c) { return c == ',' || c == ' ' || c == '\t' || c == '\r'; };
+        while (p < end) {
+            while (p < end && separator(*p))
+                p++;
+            const char* start = p;
+            while (p < end && !separator(*p))
+                p++;
+            if (p > start)
+                field(column++, start, (size_t)(p - start));
+        }
+        return;
+    }
+    while (true) {
+        const char* stop = (const char*)memchr(p, delimiter, end - p);
+        if (!stop)
+            stop = end;
+        const char* first = p;
+        const char* last = stop;
+        while (first < last && (*first == ' ' || *first == '\t' || *first == '\r'))
+            first++;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+            last--;
+        if (last > first)
+            field(column, first, (size_t)(last - first));
+        column++;
+        if (stop == end)
+            break;
+        p = stop + 1;
+    }
+}
+
+template <typename Callback>
+bool scanTransactions(const string& inputFile, char delimiter, bool hasHeader, Callback onTransaction) {
+    // Function to read a dataset one line at a time, turning each field into an item ID of the global dictionary
+    // onTransaction(items) is called for every line with at least one item; items can be modified, it is scratch space.
+    // If dictionary.attributeNames is set, field i becomes "attributeNames[i]:value" and fields past the last name are ignored;
+    // otherwise every field is an item on its own (basket data).
+    // hasHeader - the first line holds the attribute names
+    // Nothing but the dictionary is kept, so a file can be scanned several times without holding it in memory.
+    MappedFile file;
+    if (!file.open(inputFile))
+        return false;
+
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    bool headerPending = hasHeader;
+    vector<int> items; //the items of the current line
+    size_t line = 0; //number of transactions read so far
+    vector<size_t> seenIn; //basket data: the last transaction each item was read in, so repeated items are dropped
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd)
+            lineEnd = end;
+
+        if (headerPending) { //attribute names come from the first line
+            dictionary.attributeNames.clear();
+            forEachField(p, lineEnd, delimiter, [&](int column, const char* value, size_t length) {
+                dictionary.attributeNames.resize(column + 1);
+                dictionary.attributeNames[column].assign(value, length);
+            });
+            headerPending = false;
+        } else {
+            bool basket = dictionary.attributeNames.empty();
+            items.clear();
+            forEachField(p, lineEnd, delimiter, [&](int column, const char* value, size_t length) {
+                if (basket) {
+                    size_t id = dictionary.intern(-1, value, length);
+                    if (id >= seenIn.size())
+                        seenIn.resize(id + 1, (size_t)-1);
+                    if (seenIn[id] != line) { //an item counts once per transaction
+                        seenIn[id] = line;
+                        items.push_back(id);
+                    }
+                }
+                else if (column < (int)dictionary.attributeNames.size())
+                    items.push_back(dictionary.intern(column, value, length));
+            });
+            if (!items.empty()) { //skip lines without any item
+                line++;
+                onTransaction(items);
+            }
+        }
+        p = lineEnd + 1;
+    }
+    return true;
+}
+
+bool loadTransactions(const string& inputFile, char delimiter, bool hasHeader, TransactionDatabase& database) {
+    // Function to read a whole dataset into database (see scanTransactions)
+    return scanTransactions(inputFile, delimiter, hasHeader, [&](vector<int>& items) {
+        database.items.insert(database.items.end(), items.begin(), items.end());
+        database.starts.push_back(database.items.size());
+    });
+}
+
+template <typename T>
+bool readVarint(const char*& p, const char* end, T& value) { //read a varint written by writeVarint into an unsigned T;
+                                                             //false if the bytes run out or the value does not fit T
+    value = 0;
+    for (int shift = 0; p < end && shift < (int)sizeof(T) * 8; shift += 7) {
+        unsigned char byte = *p++;
+        value |= (T)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool saveTree(const string& path, FPNode* root, size_t numTransactions) {
+    // Function to write the FP-tree and the dictionary to a file, so that later batches can be added to it (see loadTree)
+    // Layout: "FPGT", the number of transactions, the attribute names, every item as name, column + 1 and support,
+    // then the number of children of the root and every other node in preorder as item ID, count and number of children.
+    // All integers are varints as in the binary output. The tree is written to path + ".tmp" and renamed over path only
+    // once the whole file is on disk, so a failed write never destroys the tree it was loaded from. A target that exists
+    // but is not a regular file (a device or a pipe) is written directly.
+    struct stat info;
+    bool direct = stat(path.c_str(), &info) == 0 && !S_ISREG(info.st_mode);
+    string tmpPath = direct ? path : path + ".tmp";
+    ofstream out(tmpPath, ios::binary);
+    if (!out.is_open())
+        return false;
+    string data = "FPGT";
+    writeVarint(data, numTransactions);
+    writeVarint(data, dictionary.attributeNames.size());
+    for (const string& name : dictionary.attributeNames) {
+        writeVarint(data, name.size());
+        data += name;
+    }
+    writeVarint(data, dictionary.names.size());
+    for (size_t id = 0; id < dictionary.names.size(); id++) {
+        writeVarint(data, dictionary.names[id].size());
+        data += dictionary.names[id];
+        writeVarint(data, dictionary.columns[id] + 1);
+        writeVarint(data, dictionary.counts[id]);
+    }
+
+    auto numChildren = [](FPNode* node) {
+        unsigned int n = 0;
+        for (FPNode* child = node->firstChild; child; child = child->nextSibling)
+            n++;
+        return n;
+    };
+    writeVarint(data, numChildren(root));
+    vector<FPNode*> stack; //nodes still to write; a node comes before its children and its children before its next sibling
+    if (root->firstChild)
+        stack.push_back(root->firstChild);
+    while (!stack.empty()) {
+        FPNode* node = stack.back();
+        stack.pop_back();
+        writeVarint(data, node->item);
+        writeVarint(data, node->count);
+        writeVarint(data, numChildren(node));
+        if (node->nextSibling)
+            stack.push_back(node->nextSibling);
+        if (node->firstChild)
+            stack.push_back(node->firstChild);
+        if (data.size() >= (1 << 16)) {
+            out.write(data.data(), data.size());
+            data.clear();
+        }
+    }
+    out.write(data.data(), data.size());
+    out.close();
+    if (direct)
+        return !out.fail();
+    if (out.fail() || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadTree(const string& path, NodeArena& arena, FPNode*& root, HeaderTable& headerTable, size_t& numTransactions) {
+    // Function to read a tree written by saveTree into an empty dictionary, arena and header table
+    // Returns false if the file cannot be read or is not a saved tree.
+    MappedFile file;
+    if (!file.open(path) || file.size < 4 || memcmp(file.data, "FPGT", 4) != 0)
+        return false;
+    const char* p = file.data + 4;
+    const char* end = file.data + file.size;
+    auto readString = [&](string& text) {
+        unsigned int length;
+        if (!readVarint(p, end, length) || length > (size_t)(end - p))
+            return false;
+        text.assign(p, length);
+        p += length;
+        return true;
+    };
+
+    unsigned int value, count, children;
+    unsigned long long transactions; //written as size_t, so it can pass 2^32
+    if (!readVarint(p, end, transactions) || transactions > MAX_TRANSACTIONS)
+        return false;
+    numTransactions = transactions;
+    if (!readVarint(p, end, value) || value > (size_t)(end - p)) //a count larger than the file is left could not be read
+        return false;                                           //anyway; checking it first keeps resize() from exhausting memory
+    dictionary.attributeNames.resize(value);
+    for (string& name : dictionary.attributeNames)
+        if (!readString(name))
+            return false;
+    if (!readVarint(p, end, value) || value > (size_t)(end - p) / 3) //an item takes at least 3 bytes: name length, column, count
+        return false;
+    dictionary.names.resize(value);
+    dictionary.columns.resize(value);
+    dictionary.counts.resize(value);
+    for (size_t id = 0; id < dictionary.names.size(); id++) {
+        if (!readString(dictionary.names[id]) || !readVarint(p, end, value) || !readVarint(p, end, count)
+            || value > dictionary.attributeNames.size() || count > transactions)
+            return false;
+        dictionary.columns[id] = (int)value - 1;
+        if (value > 0) { //an attribute item is named "attribute:value"
+            const string& attribute = dictionary.attributeNames[value - 1];
+            const string& name = dictionary.names[id];
+            if (name.size() <= attribute.size() || name.compare(0, attribute.size(), attribute) != 0 || name[attribute.size()] != ':')
+                return false;
+        }
+        dictionary.counts[id] = count;
+    }
+    dictionary.reindex();
+
+    root = arena.newNode();
+    headerTable.assign(dictionary.names.size(), {});
+    if (!readVarint(p, end, children))
+        return false;
+    struct Pending { FPNode* node; unsigned int children; FPNode* lastChild; }; //a node whose children are being read
+    vector<Pending> stack = {{root, children, nullptr}};
+    while (!stack.empty()) {
+        Pending& top = stack.back();
+        if (top.children == 0) {
+            stack.pop_back();
+            continue;
+        }
+        top.children--;
+        if (!readVarint(p, end, value) || !readVarint(p, end, count) || !readVarint(p, end, children)
+            || value >= dictionary.names.size() || count == 0 || count > transactions)
+            return false;
+        if ((int)value <= top.node->item || (top.lastChild && (int)value <= top.lastChild->item))
+            return false; //items go up along a path (so none repeats) and children are sorted, which the miner relies on
+        FPNode* node = arena.newNode(value, top.node);
+        node->count = count;
+        if (top.lastChild) //children were written in order, so each one goes at the end of the list
+            top.lastChild->nextSibling = node;
+        else
+            top.node->firstChild = node;
+        top.lastChild = node;
+        if (!headerTable[value].empty())
+            headerTable[value].back()->nodeLink = node;
+        headerTable[value].push_back(node);
+        stack.push_back({node, children, nullptr});
+    }
+    return p == end;
+}
+
+FPNode* reorderTree(FPNode* root, const vector<int>& remap, NodeArena& arena, HeaderTable& headerTable) {
+    // Function to rebuild a tree in a new item order without going back to the transactions (CP-tree restructuring)
+    // A node stands for its count minus the counts of its children transactions that end there; those transactions
+    // are inserted into the new tree with their items renumbered by remap and sorted by the new IDs.
+    FPNode* newRoot = arena.newNode();
+    headerTable.assign(remap.size(), {});
+    vector<int> path; //items from the root down to the current node
+    vector<int> transaction; //the same items, renumbered and sorted
+    vector<pair<FPNode*, size_t>> stack; //nodes still to visit, with the number of items above them
+    if (root->firstChild)
+        stack.push_back({root->firstChild, 0});
+    while (!stack.empty()) {
+        FPNode* node = stack.back().first;
+        path.resize(stack.back().second);
+        stack.pop_back();
+        path.push_back(node->item);
+
+        int ending = node->count; //transactions that end at this node
+        for (FPNode* child = node->firstChild; child; child = child->nextSibling)
+            ending -= child->count;
+        if (ending > 0) {
+            transaction.clear();
+            for (int item : path)
+                transaction.push_back(remap[item]);
+            sort(transaction.begin(), transaction.end());
+            insertTransaction(newRoot, transaction, headerTable, arena, ending);
+        }
+
+        if (node->nextSibling)
+            stack.push_back({node->nextSibling, path.size() - 1});
+        if (node->firstChild)
+            stack.push_back({node->firstChild, path.size()});
+    }
+    return newRoot;
+}
+
+typedef function<void(const function<void(vector<int>&)>&)> TransactionSource; //calls its argument once per transaction
+                                                                                //(item IDs in ascending order, scratch space)
+
+struct PartitionContext { //Settings shared by every level of the out-of-core miner
+    int minSupport; //minimum support as a number of transactions
+    long long budgetNodes; //FP-tree nodes one worker may hold at a time
+    string directory; //where the partition files go
+    atomic<int> nextFile{0}; //numbers the partition files
+};
+
+string partitionPrefix(pid_t pid) { //start of the names of the partition files of process pid
+    return "fpgrowth-" + to_string(pid) + "-";
+}
+
+void removePartitionFiles(const string& directory, pid_t pid) {
+    // Function to delete the partition files a process left in directory, e.g. after it was killed
+    string prefix = partitionPrefix(pid);
+    DIR* dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent* entry = readdir(dir)) {
+        string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0 && name.size() > 5 && name.compare(name.size() - 5, 5, ".part") == 0)
+            unlink((directory + "/" + name).c_str());
+    }
+    closedir(dir);
+}
+
+class PartitionWriter { //Appends transactions to one file per partition
+                        //Each partition buffers its records and appends them to its file in chunks, so only a few
+                        //files are open at a time. A record is the length, the distance back to the partition
+                        //the same transaction wrote its previous record to (0: none) and the delta-coded item IDs,
+                        //all as varints.
+public:
+    PartitionWriter(size_t numPartitions, PartitionContext& context)
+        : buffers(numPartitions), paths(numPartitions), started(numPartitions, false) {
+        for (string& path : paths)
+            path = context.directory + "/" + partitionPrefix(getpid()) + to_string(context.nextFile++) + ".part";
+        flushSize = max<size_t>(4096, (context.budgetNodes * sizeof(FPNode)) / (4 * numPartitions + 1));
+    }
+
+    void add(size_t partition, size_t above, const int* items, size_t length) {
+        string& buffer = buffers[partition];
+        writeVarint(buffer, length);
+        writeVarint(buffer, above);
+        int previous = 0;
+        for (size_t i = 0; i < length; i++) { //ascending IDs, so the gaps are small
+            writeVarint(buffer, items[i] - previous);
+            previous = items[i];
+        }
+        if (buffer.size() >= flushSize)
+            flush(partition);
+    }
+
+    bool flush(size_t partition) {
+        //the first write truncates: a killed run with the same process ID may have left a file of this name
+        ofstream out(paths[partition], ios::binary | (started[partition] ? ios::app : ios::trunc));
+        started[partition] = true;
+        out.write(buffers[partition].data(), buffers[partition].size());
+        string().swap(buffers[partition]); //give the memory back
+        out.close();
+        if (out.fail())
+            failed = true; //the records are lost, so the partition stays wrong even if later writes succeed
+        return !out.fail();
+    }
+
+    bool flushAll() { //false if any write since the start failed
+        for (size_t partition = 0; partition < buffers.size(); partition++)
+            flush(partition);
+        return !failed;
+    }
+
+    const string& path(size_t partition) const { return paths[partition]; }
+
+private:
+    vector<string> buffers; //records not yet written, per partition
+    vector<string> paths; //file of each partition
+    vector<bool> started; //whether each file was written to yet
+    size_t flushSize; //buffer size that triggers a write
+    bool failed = false; //a write failed
+};
+
+bool readPartition(const string& path, const function<void(vector<int>&, unsigned int)>& onTransaction) {
+    // Function to call onTransaction(items, above) for every record of a partition file written by PartitionWriter
+    // Returns false if the file cannot be read or ends inside a record.
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    vector<int> items;
+    unsigned int length, above, gap;
+    while (p < end) {
+        if (!readVarint(p, end, length) || !readVarint(p, end, above))
+            return false;
+        items.clear();
+        int item = 0;
+        for (unsigned int i = 0; i < length; i++) {
+            if (!readVarint(p, end, gap))
+                return false;
+            item += gap;
+            items.push_back(item);
+        }
+        onTransaction(items, above);
+    }
+    return true;
+}
+
+bool minePartitioned(const TransactionSource& source, vector<int> counts, const vector<int>& pattern,
+                     PartitionContext& context, const vector<ResultSink*>& sinks) {
+    // Function to mine a transaction database that does not have to fit in memory (projected-database FP-growth)
+    // source - enumerates the transactions; it is scanned a few times but never held in memory
+    // counts - support of each item ID in source (empty: counted with one more scan)
+    // pattern - itemset every transaction of source is conditioned on; it is part of every result
+    // sinks - one per worker; the partitions of this level are mined by that many threads, deeper levels by one
+    //
+    // If the FP-tree of source fits the node budget, it is built and mined directly. Otherwise the frequent items
+    // are cut into ranges of consecutive IDs whose trees are estimated to fit, and every transaction writes, for each
+    // range it has items of, its prefix up to its last item of that range to the range's partition file. The
+    // partition of a range then holds, for each of its items, exactly the transactions and prefixes that FP-growth
+    // looks at for that item, so its tree is mined for the items of the range only. An item whose partition alone is
+    // too large goes one level deeper: its partition, without the item itself, is its conditional database.
+    // Returns false if a partition file could not be written.
+    int minSupport = context.minSupport;
+    if (counts.empty())
+        source([&](vector<int>& transaction) {
+            for (int item : transaction) {
+                if (item >= (int)counts.size())
+                    counts.resize(item + 1, 0);
+                counts[item]++;
+            }
+        });
+    auto frequentOnly = [&](vector<int>& transaction) { //drop the items below minSupport
+        transaction.erase(remove_if(transaction.begin(), transaction.end(), [&](int item) {
+            return counts[item] < minSupport;
+        }), transaction.end());
+    };
+
+    vector<long long> cost(counts.size(), 0); //items of the prefixes that end at each item: bounds its partition's tree
+    {
+        NodeArena arena; //the tree of source, built while it stays inside the budget
+        HeaderTable header(counts.size());
+        FPNode* root = arena.newNode();
+        bool fits = true;
+        source([&](vector<int>& transaction) {
+            frequentOnly(transaction);
+            for (size_t i = 0; i < transaction.size(); i++)
+                cost[transaction[i]] += i + 1;
+            if (fits && !transaction.empty()) { //shared prefixes make the tree far smaller than the sum of the
+                insertTransaction(root, transaction, header, arena); //lengths on dense data, so measure it
+                fits = (long long)arena.nodesInUse() - 1 <= context.budgetNodes; //the root is not counted
+            }
+        });
+        if (fits) { //small enough to mine in memory
+            miningStats.partitions++;
+            MiningStats::raise(miningStats.largestTree, (long long)arena.nodesInUse());
+            if (pattern.empty() && sinks.size() > 1) {
+                vector<ResultSink*> workers = sinks;
+                mineFPTreeParallel(header, minSupport, workers);
+            } else {
+                mineFPTree(header, minSupport, *sinks[0], pattern);
+            }
+            return true;
+        }
+    }
+
+    vector<pair<int, int>> ranges; //first and last item ID of each partition, starting with the least frequent items
+    vector<int> rangeOf(counts.size(), -1); //partition of each frequent item
+    long long rangeCost = 0;
+    for (int item = counts.size() - 1; item >= 0; item--) {
+        if (counts[item] < minSupport)
+            continue;
+        if (ranges.empty() || rangeCost + cost[item] > context.budgetNodes) { //start a new partition
+            ranges.push_back({item, item});
+            rangeCost = 0;
+        }
+        ranges.back().first = item;
+        rangeCost += cost[item];
+        rangeOf[item] = ranges.size() - 1;
+    }
+
+    PartitionWriter writer(ranges.size(), context);
+    source([&](vector<int>& transaction) {
+        frequentOnly(transaction);
+        int last = -1; //the items of one range are next to each other, so each prefix is written once
+        for (size_t i = transaction.size(); i-- > 0;) {
+            if (rangeOf[transaction[i]] != last) {
+                int range = rangeOf[transaction[i]];
+                writer.add(range, last < 0 ? 0 : range - last, transaction.data(), i + 1);
+                last = range;
+            }
+        }
+    });
+    if (!writer.flushAll()) {
+        for (size_t r = 0; r < ranges.size(); r++)
+            unlink(writer.path(r).c_str());
+        return false;
+    }
+
+    // The bounds behind the ranges are loose, so a worker mines a run of neighbouring partitions as one tree while
+    // the tree it measures stays inside the budget. For a run first .. r, partition r contributes only the records
+    // of transactions without a record in first .. r - 1: the prefix up to the last item of the run is written once.
+    atomic<size_t> nextRange(0);
+    atomic<bool> ok(true);
+    auto worker = [&](ResultSink& out) {
+        NodeArena arena; //tree of the partitions being mined; this thread reuses it for every run it takes
+        HeaderTable header;
+        MiningContext mining; //frames and buffers of mineFPTree, also kept from one run to the next
+        FPNode* root = nullptr; //root of the tree in arena
+        auto add = [&](size_t first, size_t r) { //add partition r to the tree of the run from first; false once it exceeds the budget
+            bool fits = true;
+            if (!readPartition(writer.path(r), [&](vector<int>& transaction, unsigned int above) {
+                    if (fits && (above == 0 || above > r - first)) {
+                        insertTransaction(root, transaction, header, arena);
+                        fits = (long long)arena.nodesInUse() - 1 <= context.budgetNodes;
+                    }
+                }))
+                ok = false;
+            return fits;
+        };
+        auto build = [&](size_t first, size_t last) { //tree of the partitions first .. last; false once it exceeds the budget
+            arena.reset();
+            for (auto& nodes : header) //clear() keeps the capacity of each node list
+                nodes.clear();
+            header.resize(ranges[first].second + 1);
+            root = arena.newNode();
+            bool fits = true;
+            for (size_t r = first; r <= last && fits; r++)
+                fits = add(first, r);
+            return fits;
+        };
+
+        size_t first = nextRange++;
+        while (first < ranges.size()) {
+            if (!build(first, first)) { //ranges of several items fit by construction, so this is one item
+                NodeArena().swap(arena); //give the memory back before going deeper
+                HeaderTable().swap(header);
+                mining = MiningContext();
+                const string& path = writer.path(first);
+                vector<int> itemPattern = pattern;
+                itemPattern.push_back(ranges[first].first);
+                out.add(itemPattern, counts[ranges[first].first]);
+                bool read = true; //every scan of the partition read all of it
+                TransactionSource conditional = [&](const function<void(vector<int>&)>& onTransaction) {
+                    read = readPartition(path, [&](vector<int>& transaction, unsigned int) {
+                        transaction.pop_back(); //every record ends with the item
+                        onTransaction(transaction);
+                    }) && read;
+                };
+                if (!minePartitioned(conditional, {}, itemPattern, context, {&out}) || !read)
+                    ok = false;
+                unlink(path.c_str());
+                first = nextRange++;
+                continue;
+            }
+
+            size_t last = first; //take the following partitions while no other worker has and the tree still fits
+            size_t next = first + 1; //each one is added to the tree as it is, so every partition is read once
+            bool grown = true;
+            while (grown && next < ranges.size() && nextRange.compare_exchange_strong(next, next + 1)) {
+                grown = add(first, next);
+                if (grown)
+                    last = next++;
+            }
+            if (!grown) //the last partition taken overflowed: rebuild without it, it starts the next run
+                build(first, last);
+            miningStats.partitions++;
+            MiningStats::raise(miningStats.largestTree, (long long)arena.nodesInUse());
+            vector<pair<int, int>> items; //the items this run is mined for
+            for (auto& entry : frequentItems(header, minSupport))
+                if (entry.first >= ranges[last].first)
+                    items.push_back(entry);
+            if (!items.empty())
+                mineFPTree(header, minSupport, out, pattern, &items, ALL_ITEMSETS, &mining);
+            for (size_t r = first; r <= last; r++)
+                unlink(writer.path(r).c_str());
+            first = grown ? nextRange++ : last + 1;
+        }
+    };
+
+    vector<thread> threads;
+    for (size_t w = 1; w < sinks.size(); w++)
+        threads.emplace_back([&, w]() { worker(*sinks[w]); });
+    worker(*sinks[0]);
+    for (thread& t : threads)
+        t.join();
+    return ok;
+}
+
+struct QuestParameters { //Shape of an IBM Quest-style synthetic basket dataset, written like "T10I4D100K"
+    double avgTransaction = 10; //T: average transaction length
+    double avgPattern = 4; //I: average length of the potentially frequent itemsets
+    long long numTransactions = 100000; //D: number of transactions
+    int numItems = 1000; //N: number of distinct items
+    int numPatterns = 2000; //L: number of potentially frequent itemsets
+};
+
+bool parseQuestSpec(const string& spec, QuestParameters& params) {
+    // Function to read a spec such as "T10I4D100K" or "T40I10D100KN1K"; a K or M after a number multiplies it
+    const char* p = spec.c_str();
+    while (*p) {
+        char key = toupper(*p++);
+        char* end;
+        double value = strtod(p, &end);
+        if (end == p || value <= 0)
+            return false;
+        p = end;
+        if (*p == 'K' || *p == 'k') {
+            value *= 1000;
+            p++;
+        } else if (*p == 'M' || *p == 'm') {
+            value *= 1000000;
+            p++;
+        }
+        if (key == 'T')
+            params.avgTransaction = value;
+        else if (key == 'I')
+            params.avgPattern = value;
+        else if (key == 'D')
+            params.numTransactions = (long long)value;
+        else if (key == 'N')
+            params.numItems = (int)value;
+        else if (key == 'L')
+            params.numPatterns = (int)value;
+        else
+            return false;
+    }
+    return params.numTransactions > 0 && params.numItems > 0 && params.numPatterns > 0;
+}
+
+bool generateQuest(const QuestParameters& params, const string& path, unsigned int seed = 1) {
+    // Function to write a synthetic basket dataset the way the IBM Quest generator (Agrawal and Srikant) does
+    // First a pool of potentially frequent itemsets is drawn: Poisson sizes around I, each sharing an exponentially
+    // distributed fraction (mean 0.5) of its items with the previous one, with exponential weights and a corruption
+    // level drawn from N(0.5, 0.1). Every transaction has a Poisson size around T and is filled with itemsets picked
+    // by weight; items are dropped from a picked itemset while a uniform draw stays below its corruption level.
+    // An itemset that does not fit is added anyway half of the time and otherwise moved to the next transaction.
+    // The same parameters and seed always give the same file.
+    ofstream out(path);
+    if (!out.is_open())
+        return false;
+    mt19937 rng(seed);
+    uniform_real_distribution<double> uniform(0, 1);
+    uniform_int_distribution<int> anyItem(0, params.numItems - 1);
+    // Sizes are 1 plus a Poisson draw. A Poisson mean must be above 0, so with I or T of 1 or less the size is always 1.
+    double patternMean = params.avgPattern - 1, transactionMean = params.avgTransaction - 1;
+    poisson_distribution<int> patternSize(patternMean > 0 ? patternMean : 1);
+    poisson_distribution<int> transactionSize(transactionMean > 0 ? transactionMean : 1);
+    exponential_distribution<double> shared(2.0); //mean 0.5
+    exponential_distribution<double> weight(1.0);
+    normal_distribution<double> corruptionLevel(0.5, 0.1);
+
+    vector<vector<int>> patterns(params.numPatterns); //the potentially frequent itemsets
+    vector<double> weights(params.numPatterns);
+    vector<double> corruption(params.numPatterns);
+    for (int k = 0; k < params.numPatterns; k++) {
+        size_t size = min<size_t>((patternMean > 0 ? patternSize(rng) : 0) + 1, params.numItems); //at least one item
+        vector<int>& pattern = patterns[k];
+        if (k > 0) { //take a part of the previous itemset
+            const vector<int>& previous = patterns[k - 1];
+            size_t take = min(size, (size_t)(min(shared(rng), 1.0) * previous.size() + 0.5));
+            for (size_t i = 0; i < take; i++)
+                pattern.push_back(previous[uniform_int_distribution<size_t>(0, previous.size() - 1)(rng)]);
+        }
+        sort(pattern.begin(), pattern.end());
+        pattern.erase(unique(pattern.begin(), pattern.end()), pattern.end());
+        while (pattern.size() < size) { //the rest are new random items
+            int item = anyItem(rng);
+            if (find(pattern.begin(), pattern.end(), item) == pattern.end())
+                pattern.push_back(item);
+        }
+        weights[k] = weight(rng);
+        corruption[k] = min(max(corruptionLevel(rng), 0.0), 1.0);
+    }
+    discrete_distribution<int> pick(weights.begin(), weights.end()); //normalizes the weights
+
+    vector<int> transaction, carried; //the transaction being filled, and an itemset left over from the previous one
+    string line;
+    for (long long t = 0; t < params.numTransactions; t++) {
+        size_t size = (transactionMean > 0 ? transactionSize(rng) : 0) + 1; //at least one item
+        transaction.clear();
+        while (transaction.size() < size) {
+            vector<int> chosen;
+            if (!carried.empty()) {
+                chosen.swap(carried);
+            } else {
+                int k = pick(rng);
+                chosen = patterns[k];
+                while (!chosen.empty() && uniform(rng) < corruption[k]) //corrupt the itemset
+                    chosen.erase(chosen.begin() + uniform_int_distribution<size_t>(0, chosen.size() - 1)(rng));
+            }
+            if (!transaction.empty() && transaction.size() + chosen.size() > size && uniform(rng) < 0.5) {
+                carried.swap(chosen); //does not fit: keep it for the next transaction
+                break;
+            }
+            transaction.insert(transaction.end(), chosen.begin(), chosen.end());
+            if (chosen.empty() && transaction.empty()) //fully corrupted itemsets would never fill an empty transaction
+                transaction.push_back(anyItem(rng));
+        }
+        sort(transaction.begin(), transaction.end());
+        transaction.erase(unique(transaction.begin(), transaction.end()), transaction.end());
+        line.clear();
+        for (size_t i = 0; i < transaction.size(); i++) {
+            if (i)
+                line += ' ';
+            line += to_string(transaction[i]);
+        }
+        line += '\n';
+        out.write(line.data(), line.size());
+    }
+    out.close();
+    return !out.fail();
+}
+
+class PhaseTimer { //Wall time of the phases of one run, for --stats
+public:
+    PhaseTimer() : last(high_resolution_clock::now()) {}
+
+    void end(const char* phase) { //the named phase ends now and the next one starts
+        auto now = high_resolution_clock::now();
+        times.push_back({phase, duration<double>(now - last).count()});
+        last = now;
+    }
+
+    vector<pair<const char*, double>> times; //seconds spent in each phase, in order
+
+private:
+    high_resolution_clock::time_point last; //end of the previous phase
+};
+
+string jsonString(const string& text) { //text as a quoted JSON string
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+long peakRssKb() { //largest resident set size of this process so far, in KiB
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void printUsage(const char* program) {
+    cerr << "FP-Growth Algorithm\n"
+         << "Usage: " << program << " <input_file> <min_support> [output_file] [options]\n"
+         << "       " << program << " --dataset N <min_support> [output_file] [options]\n"
+         << "Options:\n"
+         << "  -d, --delimiter C     field delimiter (default: commas and whitespace; use \\t for tab)\n"
+         << "      --header          the first line of the file holds the attribute names\n"
+         << "      --attributes A,B  attribute names; fields become \"name:value\" items\n"
+         << "      --dataset N       use the file name and attribute names of a built-in dataset\n"
+         << "  -t, --threads N       number of mining threads (default: 1)\n"
+         << "  -m, --mode MODE       output mode: text, count or binary (default: text)\n"
+         << "      --closed          report only closed itemsets (runs on one thread)\n"
+         << "      --maximal         report only maximal itemsets (runs on one thread)\n"
+         << "  -k, --top-k K         report only the K most frequent itemsets (ties with the K-th included);\n"
+         << "                        <min_support> is optional then\n"
+         << "  -r, --rules           output association rules instead of itemsets (text or count mode)\n"
+         << "      --min-confidence C  minimum confidence of a rule, 0 to 1 (default: 0.5; implies --rules)\n"
+         << "      --min-lift L      minimum lift of a rule (default: 0; implies --rules)\n"
+         << "      --print-tree      print the constructed FP-tree\n"
+         << "      --save-tree FILE  save the FP-tree (with every item, frequent or not) so later batches can be added\n"
+         << "      --load-tree FILE  start from a saved FP-tree; the input file then holds only the new transactions\n"
+         << "      --reorder         with --load-tree: restructure the tree by the current item supports\n"
+         << "      --memory-budget MB  mine out of core: the file is split into partitions on disk whose FP-trees fit MB\n"
+         << "      --temp-dir DIR    directory for the partitions (default: $TMPDIR or /tmp)\n"
+         << "  -e, --engine E        mining engine: fptree, bitmap (item bitsets, for dense data) or auto (default:\n"
+         << "                        bitmap when the frequent items fill enough of the transactions)\n"
+         << "      --stats FILE      append the phase timings and counters of the run to FILE as a JSON line\n"
+         << "With --save-tree, <min_support> is optional; without it the tree is only updated and saved.\n"
+         << "Benchmarks: " << program << " --bench FILE [--timeout SEC] [options]\n"
+         << "            runs the built-in datasets found in the current directory and T10I4D100K/T40I10D100K\n"
+         << "            at decreasing supports, one --stats line per run\n"
+         << "Synthetic data: " << program << " --generate SPEC FILE   (IBM Quest style, e.g. T10I4D100K, N1K, L2K)\n"
+         << "<min_support> is a number of transactions, or a fraction of them when it has a '.' or ends in '%'\n"
+         << "(0.3 and 30% both mean 30 percent of the transactions).\n"
+         << "Without attribute names every field is an item on its own.\n"
+         << "Built-in datasets:\n";
+    for (size_t i = 0; i < knownDatasets.size(); i++)
+        cerr << "  " << (i + 1) << ". " << knownDatasets[i].title << " (" << knownDatasets[i].inputFile << ")\n";
+}
+
+bool parseSupport(const string& text, double& value, bool& relative) {
+    // Function to read a minimum support: a transaction count, or a fraction of the transactions ("0.3" or "30%")
+    // Counts above INT_MAX, infinities and NaN are rejected.
+    char* end;
+    value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || !isfinite(value) || value < 0)
+        return false;
+    relative = text.find('.') != string::npos;
+    if (*end == '%') {
+        value /= 100;
+        relative = true;
+        end++;
+    }
+    return *end == '\0' && (relative ? value <= 1 : value <= INT_MAX);
+}
+
+int runMiner(int argc, char* argv[]) {
+    // Function to run the miner with the command line described in printUsage
+    string inputFile; //string to store dataset filename
+    string outputFile; //file that receives the itemsets (empty: text to the console, binary to frequent_itemsets.bin)
+    char delimiter = 0; //field delimiter (0: commas and whitespace)
+    bool hasHeader = false; //first line holds the attribute names
+    int dataset = 0; //built-in dataset number (0: none)
+    int numThreads = 1; //number of mining threads
+    string outputMode = "text"; //text, count or binary
+    bool printTree = false; //print the FP-tree before mining
+    MiningMode miningMode = ALL_ITEMSETS; //all, closed or maximal itemsets
+    string loadTreeFile; //saved FP-tree the input file is added to (empty: build the tree from scratch)
+    string saveTreeFile; //file that receives the FP-tree once the input file is in it
+    bool reorder = false; //restructure a loaded tree by the current supports
+    long long topK = 0; //number of most frequent itemsets to report (0: all of them)
+    bool rules = false; //derive association rules from the itemsets
+    double minConfidence = 0.5; //minimum confidence of a rule
+    double minLift = 0; //minimum lift of a rule
+    string statsFile; //file that gets a JSON line with the timings and counters of this run (empty: none)
+    long long memoryBudget = 0; //megabytes the FP-trees may take; the file is mined out of core (0: in memory)
+    string tempDir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp"; //where the out-of-core miner puts its partitions
+    string engine = "auto"; //mining engine: fptree, bitmap, or auto to choose by the density of the data
+    vector<string> positional; //arguments that are not options
+
+    for (int i = 1; i < argc; i++) { //parse the command line
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-d" || arg == "--delimiter") && hasValue) {
+            string value = argv[++i];
+            delimiter = (value == "\\t" || value == "tab") ? '\t' : value[0];
+        } else if (arg == "--header") {
+            hasHeader = true;
+        } else if (arg == "--attributes" && hasValue) {
+            string list = argv[++i];
+            forEachField(list.data(), list.data() + list.size(), ',', [&](int column, const char* value, size_t length) {
+                dictionary.attributeNames.resize(column + 1);
+                dictionary.attributeNames[column].assign(value, length);
+            });
+        } else if (arg == "--dataset" && hasValue) {
+            dataset = atoi(argv[++i]);
+            if (dataset < 1 || dataset > (int)knownDatasets.size()) {
+                cerr << "Invalid dataset: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if ((arg == "-t" || arg == "--threads") && hasValue) {
+            numThreads = max(1, atoi(argv[++i]));
+        } else if ((arg == "-m" || arg == "--mode") && hasValue) {
+            outputMode = argv[++i];
+            if (outputMode != "text" && outputMode != "count" && outputMode != "binary") {
+                cerr << "Invalid output mode: " << outputMode << "\n";
+                return 1;
+            }
+        } else if (arg == "--closed") {
+            miningMode = CLOSED_ITEMSETS;
+        } else if (arg == "--maximal") {
+            miningMode = MAXIMAL_ITEMSETS;
+        } else if ((arg == "-k" || arg == "--top-k") && hasValue) {
+            topK = atoll(argv[++i]);
+            if (topK < 1) {
+                cerr << "Invalid top-k: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "-r" || arg == "--rules") {
+            rules = true;
+        } else if (arg == "--min-confidence" && hasValue) {
+            minConfidence = atof(argv[++i]);
+            rules = true;
+        } else if (arg == "--min-lift" && hasValue) {
+            minLift = atof(argv[++i]);
+            rules = true;
+        } else if (arg == "--load-tree" && hasValue) {
+            loadTreeFile = argv[++i];
+        } else if (arg == "--save-tree" && hasValue) {
+            saveTreeFile = argv[++i];
+        } else if (arg == "--reorder") {
+            reorder = true;
+        } else if (arg == "--memory-budget" && hasValue) {
+            memoryBudget = atoll(argv[++i]);
+            if (memoryBudget < 1) {
+                cerr << "Invalid memory budget: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--temp-dir" && hasValue) {
+            tempDir = argv[++i];
+        } else if ((arg == "-e" || arg == "--engine") && hasValue) {
+            engine = argv[++i];
+            if (engine != "fptree" && engine != "bitmap" && engine != "auto") {
+                cerr << "Invalid engine: " << engine << "\n";
+                return 1;
+            }
+        } else if (arg == "--stats" && hasValue) {
+            statsFile = argv[++i];
+        } else if (arg == "--print-tree") {
+            printTree = true;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            cerr << "Unknown option: " << arg << "\n";
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (dataset > 0) { //the built-in dataset supplies the file and attribute names
+        inputFile = knownDatasets[dataset - 1].inputFile;
+        dictionary.attributeNames = knownDatasets[dataset - 1].attributeNames;
+        positional.insert(positional.begin(), inputFile);
+    }
+    double supportValue = 1; //the minimum support as given
+    bool relativeSupport = false; //supportValue is a fraction of the transactions
+    bool hasSupport = positional.size() >= 2 && parseSupport(positional[1], supportValue, relativeSupport);
+    bool mine = hasSupport || topK; //without a support and top-k the tree is only built and saved
+    if (positional.size() >= 2 && !mine) {
+        cerr << "Invalid minimum support: " << positional[1] << "\n";
+        return 1;
+    }
+    if (positional.empty() || (!mine && saveTreeFile.empty()) || positional.size() > (hasSupport ? 3u : 2u)) {
+        printUsage(argv[0]); //with --top-k or --save-tree the minimum support may be left out
+        return 1;
+    }
+    inputFile = positional[0];
+    if (positional.size() > (hasSupport ? 2u : 1u))
+        outputFile = positional.back();
+
+    if (topK && miningMode != ALL_ITEMSETS) {
+        cerr << "--top-k cannot be combined with --closed or --maximal\n";
+        return 1;
+    }
+    if (rules && miningMode != ALL_ITEMSETS) { //the support of every rule side has to be known
+        cerr << "--rules cannot be combined with --closed or --maximal\n";
+        return 1;
+    }
+    if (rules && outputMode == "binary") {
+        cerr << "Rules are written as text; use --mode text or count\n";
+        return 1;
+    }
+    if (memoryBudget && (miningMode != ALL_ITEMSETS || !loadTreeFile.empty() || !saveTreeFile.empty() || printTree || !mine)) {
+        cerr << "--memory-budget mines all itemsets of one file; it cannot be combined with --closed, --maximal,\n"
+             << "--load-tree, --save-tree or --print-tree\n";
+        return 1;
+    }
+    if (memoryBudget && access(tempDir.c_str(), W_OK) != 0) {
+        cerr << "Cannot write to directory: " << tempDir << "\n";
+        return 1;
+    }
+    if (engine == "bitmap" && (miningMode != ALL_ITEMSETS || !loadTreeFile.empty() || memoryBudget)) {
+        cerr << "--engine bitmap mines all itemsets of the transactions in memory; it cannot be combined with --closed,\n"
+             << "--maximal, --load-tree or --memory-budget\n";
+        return 1;
+    }
+    if (miningMode != ALL_ITEMSETS) //pruning against the results found so far needs the sequential mining order
+        numThreads = 1;
+
+    countAllocations = !statsFile.empty();
+    PhaseTimer phases; //wall time of each phase for --stats
+
+    NodeArena arena; //Arena that owns every node of the FP-tree
+    FPNode* root; //the FP-tree root node
+    HeaderTable headerTable; //header table which stores pointers to all nodes of each item in the FP tree
+    size_t numTransactions = 0; //transactions in the tree, including those of earlier batches
+    if (!loadTreeFile.empty()) { //the tree and the dictionary of the earlier batches
+        vector<string> givenNames = dictionary.attributeNames;
+        if (!loadTree(loadTreeFile, arena, root, headerTable, numTransactions)) {
+            cerr << "Cannot read saved tree: " << loadTreeFile << "\n";
+            return 1;
+        }
+        if (!givenNames.empty() && givenNames != dictionary.attributeNames) {
+            cerr << "The attribute names do not match the saved tree\n";
+            return 1;
+        }
+    } else {
+        root = arena.newNode();
+    }
+    vector<string> treeNames = dictionary.attributeNames;
+
+    TransactionDatabase database; //Every transaction as item IDs (out of core it stays empty and the file is only counted)
+    bool loaded = memoryBudget ? scanTransactions(inputFile, delimiter, hasHeader, [&](vector<int>& items) {
+                                     if (++numTransactions > MAX_TRANSACTIONS)
+                                         return; //rejected below; counting on could overflow the supports
+                                     for (int item : items)
+                                         dictionary.counts[item]++;
+                                 })
+                               : loadTransactions(inputFile, delimiter, hasHeader, database);
+    if (!loaded) { //open the dataset file specified by the user
+        cerr << "Cannot open file: " << inputFile << "\n";
+        return 1;
+    }
+    if (!loadTreeFile.empty() && dictionary.attributeNames != treeNames) { //a header line must name the same columns
+        cerr << "The attribute names do not match the saved tree\n";
+        return 1;
+    }
+    if (numTransactions + database.size() > MAX_TRANSACTIONS) { //with a saved tree, its transactions count as well
+        cerr << "More than " << MAX_TRANSACTIONS << " transactions are not supported\n";
+        return 1;
+    }
+
+    phases.end("load");
+    auto startTime = high_resolution_clock::now(); //Start measuring execution time
+
+    numTransactions += database.size();
+    double supportCount = relativeSupport ? ceil(supportValue * numTransactions - 1e-9) : supportValue;
+    int minSupport = (int)min(supportCount, (double)INT_MAX); //the minimum support as a number of transactions
+    minSupport = max(minSupport, 1); //an itemset has to occur at least once
+
+    for (int item : database.items) //loop through each item of every transaction
+        dictionary.counts[item]++; //count how many times each item appears in all transacations
+
+    vector<int> remap(dictionary.names.size()); //maps the IDs of the loader to the IDs of the tree
+    int numFrequent = dictionary.names.size(); //Number of items that go into the tree; they are exactly the IDs below numFrequent
+    if (loadTreeFile.empty()) {
+        remap = dictionary.rankByFrequency(); //Renumber the items so that a lower ID means a more frequent item
+        if (saveTreeFile.empty()) { //a saved tree keeps every item, since later batches can make it frequent
+            numFrequent = 0;
+            while (numFrequent < (int)dictionary.counts.size() && dictionary.counts[numFrequent] >= minSupport)
+                numFrequent++;
+        }
+    } else { //the saved order stays fixed (CanTree); items new in this batch got the next IDs, so they go below the old ones
+        for (int id = 0; id < (int)remap.size(); id++)
+            remap[id] = id;
+    }
+
+    int numMined = 0; //Number of items that are frequent at minSupport; with --save-tree the tree has the others as well
+    while (loadTreeFile.empty() && numMined < numFrequent && dictionary.counts[numMined] >= minSupport)
+        numMined++;
+    long long minedItems = 0; //occurrences of those items in all transactions
+    for (int id = 0; id < numMined; id++)
+        minedItems += dictionary.counts[id];
+    double density = numMined ? (double)minedItems / ((double)numTransactions * numMined) : 0; //share of the bits set
+    bool bitmap = mine && engine == "bitmap"; //mine the item bitsets instead of the FP-tree
+    if (engine == "auto") //dense data, where the conditional trees hardly shrink, and bitsets that fit in memory easily
+        bitmap = mine && miningMode == ALL_ITEMSETS && loadTreeFile.empty() && !memoryBudget &&
+                 density >= VerticalDatabase::MIN_DENSITY &&
+                 numMined * ((database.size() + 63) / 64) * 8 * (1 + (size_t)numThreads) <= VerticalDatabase::MAX_BYTES;
+    VerticalDatabase vertical; //the bitset of each frequent item, for the bitmap engine
+    if (bitmap)
+        vertical.resize(numMined, database.size());
+    bool buildTree = !bitmap || printTree || !saveTreeFile.empty(); //the bitmap engine only needs the tree to show or save it
+
+    phases.end("count");
+
+    headerTable.resize(numFrequent);
+    vector<int> filtered; //the current transaction without its infrequent items
+    for (size_t t = 0; t < database.size(); t++) { //loop through each transaction
+        filtered.clear();
+        for (size_t i = database.starts[t]; i < database.starts[t + 1]; i++) //loop through each item in the transaction 
+            if (remap[database.items[i]] < numFrequent) //check if the frequency of the item is atleast minSupport (also known as the threshold)
+                filtered.push_back(remap[database.items[i]]);  //If the frequency >= minSupport, add its ranked ID to filtered
+        sort(filtered.begin(), filtered.end()); //Ascending IDs are descending frequencies, which is the order the FP-tree needs
+        if (!filtered.empty() && buildTree)
+            insertTransaction(root, filtered, headerTable, arena); //insert it into the FP tree
+        if (bitmap)
+            for (int item : filtered)
+                if (item < numMined)
+                    vertical.add(item, t); //set the transaction's bit in the item's bitset
+    }
+
+    if (reorder && !loadTreeFile.empty()) { //move the tree to the order of the current supports
+        NodeArena reordered;
+        HeaderTable reorderedHeader;
+        root = reorderTree(root, dictionary.rankByFrequency(), reordered, reorderedHeader);
+        arena.swap(reordered);
+        headerTable.swap(reorderedHeader);
+    }
+    size_t treeNodes = arena.nodesCreated(); //nodes of the FP-tree, root included
+    phases.end("build");
+    if (!saveTreeFile.empty() && !saveTree(saveTreeFile, root, numTransactions)) {
+        cerr << "Cannot write saved tree: " << saveTreeFile << "\n";
+        return 1;
+    }
+    phases.end("save");
+    if (!loadTreeFile.empty() || !saveTreeFile.empty())
+        cout << "Transactions in the FP-tree: " << numTransactions << " (" << database.size() << " from " << inputFile << ")\n";
+
+    if (printTree) {
+        cout << "\nConstructed FP-tree Structure:\n"; //Print FP-tree structure
+        printFPTree(root);
+    }
+    phases.end("print");
+
+    auto writeStats = [&](long long itemsets, long long rules) { //append this run as one JSON line to statsFile
+        if (statsFile.empty())
+            return true;
+        string line = "{\"input\":" + jsonString(inputFile);
+        line += ",\"status\":\"ok\"";
+        line += ",\"transactions\":" + to_string(numTransactions);
+        line += ",\"items\":" + to_string(dictionary.names.size());
+        line += ",\"tree_items\":" + to_string(numFrequent);
+        line += ",\"min_support\":" + to_string(minSupport);
+        line += ",\"mode\":" + jsonString(miningMode == CLOSED_ITEMSETS ? "closed" : miningMode == MAXIMAL_ITEMSETS ? "maximal" : "all");
+        line += ",\"top_k\":" + to_string(topK);
+        line += ",\"threads\":" + to_string(numThreads);
+        line += ",\"engine\":" + jsonString(memoryBudget ? "partitioned" : bitmap ? "bitmap" : "fptree");
+        line += ",\"density\":" + to_string(density);
+        line += ",\"itemsets\":" + to_string(itemsets);
+        line += ",\"rules\":" + to_string(rules);
+        line += ",\"tree_nodes\":" + to_string(treeNodes);
+        line += ",\"conditional_trees\":" + to_string(miningStats.conditionalTrees.load());
+        line += ",\"conditional_nodes\":" + to_string(miningStats.conditionalNodes.load());
+        line += ",\"max_depth\":" + to_string(miningStats.maxDepth.load());
+        line += ",\"partitions\":" + to_string(miningStats.partitions.load());
+        line += ",\"intersections\":" + to_string(miningStats.intersections.load());
+        line += ",\"peak_rss_kb\":" + to_string(peakRssKb());
+        line += ",\"allocations\":" + to_string(allocationCount.load());
+        line += ",\"allocated_bytes\":" + to_string(allocationBytes.load());
+        line += ",\"seconds\":{";
+        double total = 0;
+        for (auto& phase : phases.times) {
+            line += jsonString(phase.first) + ":" + to_string(phase.second) + ",";
+            total += phase.second;
+        }
+        line += "\"total\":" + to_string(total) + "}}\n";
+        ofstream out(statsFile, ios::app);
+        out << line;
+        out.close();
+        if (out.fail()) {
+            cerr << "Cannot write stats: " << statsFile << "\n";
+            return false;
+        }
+        return true;
+    };
+
+    if (!mine) { //the tree was only updated and saved
+        duration<double> elapsedSeconds = high_resolution_clock::now() - startTime;
+        cout << "\nTree updated in " << elapsedSeconds.count() << " seconds.\n";
+        return writeStats(0, 0) ? 0 : 1;
+    }
+
+    ofstream fileOut; //Destination of the itemsets when an output file is used
+    if (outputMode == "binary" && outputFile.empty())
+        outputFile = "frequent_itemsets.bin";
+    if (outputMode != "count" && !outputFile.empty()) {
+        fileOut.open(outputFile, outputMode == "binary" ? ios::binary : ios::out);
+        if (!fileOut.is_open()) {
+            cerr << "Cannot open file: " << outputFile << "\n";
+            return 1;
+        }
+    }
+    ostream& itemsetOut = outputFile.empty() ? cout : fileOut;
+    if (outputMode == "binary")
+        BinarySink::writeHeader(itemsetOut);
+
+    vector<unique_ptr<ResultSink>> sinks; //One result sink per mining thread
+    vector<ResultSink*> sinkPointers;
+    vector<ItemsetStore*> stores; //the same sinks, when the itemsets are kept for rule generation
+    for (int t = 0; t < (topK ? 1 : numThreads); t++) { //top-k collects first and writes through a single sink afterwards
+        if (rules) {
+            stores.push_back(new ItemsetStore());
+            sinks.emplace_back(stores.back());
+        } else if (outputMode == "count")
+            sinks.emplace_back(new CountSink());
+        else if (outputMode == "binary")
+            sinks.emplace_back(new BinarySink(itemsetOut));
+        else
+            sinks.emplace_back(new TextSink(itemsetOut));
+        sinkPointers.push_back(sinks.back().get());
+    }
+    TopKCollector topKCollector(topK, minSupport); //the best itemsets so far in top-k mode
+    vector<unique_ptr<ResultSink>> topKSinks; //the sinks the miner sees in top-k mode, one per thread
+    if (topK) {
+        sinkPointers.clear();
+        for (int t = 0; t < numThreads; t++) {
+            topKSinks.emplace_back(new TopKSink(topKCollector));
+            sinkPointers.push_back(topKSinks.back().get());
+        }
+    }
+
+    phases.end("setup");
+
+    if (outputMode == "text" && outputFile.empty())
+        cout << (rules ? "\nAssociation Rules Found:\n" : "\nFrequent Itemsets Found:\n"); //Print the frequent itemsets or rules found
+    if (memoryBudget) { //mine the file partition by partition, reading it again instead of keeping it
+        PartitionContext context;
+        context.minSupport = minSupport;
+        context.budgetNodes = memoryBudget * 1024 * 1024 / numThreads //a tree node also needs a header entry, and mining
+                              / (2 * (sizeof(FPNode) + sizeof(FPNode*))); //builds conditional trees of about the same size
+        context.directory = tempDir;
+        TransactionSource source = [&](const function<void(vector<int>&)>& onTransaction) {
+            scanTransactions(inputFile, delimiter, hasHeader, [&](vector<int>& items) {
+                items.erase(remove_if(items.begin(), items.end(), [&](int item) { return item >= numFrequent; }), items.end());
+                sort(items.begin(), items.end());
+                if (!items.empty())
+                    onTransaction(items);
+            });
+        };
+        if (!minePartitioned(source, vector<int>(dictionary.counts.begin(), dictionary.counts.begin() + numFrequent), {},
+                             context, sinkPointers)) {
+            cerr << "Cannot write or read partition files in " << tempDir << "\n";
+            return 1;
+        }
+        for (ResultSink* sink : sinkPointers)
+            sink->flush();
+        treeNodes = miningStats.largestTree;
+    } else if (bitmap && numThreads == 1) {
+        vector<int> order = bitmapOrder(vertical, minSupport);
+        BitmapContext context;
+        mineBitmap(vertical, order, 0, order.size(), minSupport, *sinkPointers[0], context);
+        sinkPointers[0]->flush();
+    } else if (bitmap) {
+        mineBitmapParallel(vertical, minSupport, sinkPointers);
+    } else if (numThreads == 1) {
+        mineFPTree(headerTable, minSupport, *sinkPointers[0], {}, nullptr, miningMode);
+        sinkPointers[0]->flush();
+    } else {
+        mineFPTreeParallel(headerTable, minSupport, sinkPointers);
+    }
+    if (topK)
+        topKCollector.write(*sinks[0]);
+
+    long long totalFrequentItemsets = 0; //Total number of frequent item sets
+    for (auto& sink : sinks)
+        totalFrequentItemsets += sink->count;
+    phases.end("mine");
+
+    long long totalRules = 0; //Total number of association rules
+    if (rules) { //derive the rules from the kept itemsets
+        ItemsetTrie trie(stores, numTransactions);
+        totalRules = generateRules(stores, trie, numTransactions, minConfidence, minLift, numThreads,
+                                   outputMode == "count" ? nullptr : &itemsetOut);
+        itemsetOut.flush();
+        cout << "\nTotal Association Rules Found: " << totalRules << "\n";
+    }
+    phases.end("rules");
+
+    if (fileOut.is_open()) { //a full disk only shows once the last of the output is flushed
+        fileOut.close();
+        if (fileOut.fail()) {
+            cerr << "Cannot write file: " << outputFile << "\n";
+            return 1;
+        }
+    }
+
+    cout << "\nTotal Frequent Itemsets Found: " << totalFrequentItemsets << "\n"; //Print the total number of frequent itemsets found
+
+    topKSinks.clear(); //delete the results and the FP-tree from memory
+    sinks.clear();
+    HeaderTable().swap(headerTable);
+    NodeArena().swap(arena);
+    vertical = VerticalDatabase();
+    phases.end("teardown");
+
+    auto endTime = high_resolution_clock::now(); //Record the endtime
+    duration<double> elapsedSeconds = endTime - startTime; //compute the elapsed time since StartTime - gives us how long the algorithm took to run
+    cout << "\nAlgorithm finished in " << elapsedSeconds.count() << " seconds.\n"; //Print how long the alogrithm took to run
+
+    return writeStats(totalFrequentItemsets, totalRules) ? 0 : 1;
+}
+
+int runBenchmark(int argc, char* argv[]) {
+    // Function to run the benchmark suite: fpgrowth --bench FILE [--timeout SEC] [miner options]
+    // Every built-in dataset whose file is in the current directory, and the synthetic T10I4D100K and T40I10D100K
+    // datasets (generated on first use), are mined in count mode at decreasing relative supports. Each run is a
+    // child process, so its peak RSS and allocation counts are its own; it appends its --stats line to FILE.
+    // A dataset stops at the first run that times out or takes more than a quarter of the timeout, since lower
+    // supports only get slower. Options that are not the benchmark's own are passed to every run (e.g. -t 4).
+    string benchFile; //JSON lines output
+    int timeout = 60; //seconds a single run may take
+    vector<string> passed; //options for every run
+    string tempDir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp"; //where runs with --memory-budget put their partitions
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc)
+            benchFile = argv[++i];
+        else if (arg == "--timeout" && i + 1 < argc)
+            timeout = max(1, atoi(argv[++i]));
+        else
+            passed.push_back(arg);
+        if (arg == "--temp-dir" && i + 1 < argc)
+            tempDir = argv[i + 1];
+    }
+    if (benchFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    struct BenchCase { //one dataset of the suite
+        string name; //dataset file
+        vector<string> args; //how the miner is told about it
+        vector<double> supports; //relative supports to try, decreasing
+    };
+    vector<BenchCase> cases;
+    vector<double> denseSupports = {0.9, 0.8, 0.7, 0.6, 0.5, 0.4, 0.3, 0.2, 0.1, 0.05, 0.02, 0.01};
+    for (size_t d = 0; d < knownDatasets.size(); d++)
+        if (access(knownDatasets[d].inputFile, R_OK) == 0)
+            cases.push_back({knownDatasets[d].inputFile, {"--dataset", to_string(d + 1)}, denseSupports});
+    for (const char* spec : {"T10I4D100K", "T40I10D100K"}) {
+        string file = string(spec) + ".data";
+        QuestParameters params;
+        parseQuestSpec(spec, params);
+        if (access(file.c_str(), R_OK) != 0) {
+            cerr << "Generating " << file << "\n";
+            if (!generateQuest(params, file)) {
+                cerr << "Cannot write file: " << file << "\n";
+                return 1;
+            }
+        }
+        cases.push_back({file, {file}, {0.05, 0.02, 0.01, 0.005, 0.002, 0.001}});
+    }
+
+    for (const BenchCase& benchCase : cases) {
+        for (double support : benchCase.supports) {
+            char supportText[32];
+            snprintf(supportText, sizeof(supportText), "%g", support); //has a '.', so the miner reads it as a fraction
+            vector<string> args = {argv[0]};
+            args.insert(args.end(), benchCase.args.begin(), benchCase.args.end());
+            args.insert(args.end(), {supportText, "-m", "count", "--stats", benchFile});
+            args.insert(args.end(), passed.begin(), passed.end());
+
+            cout.flush(); //the child must not write our buffered output again
+            auto start = high_resolution_clock::now();
+            pid_t child = fork();
+            if (child < 0) {
+                cerr << "Cannot start a benchmark run\n";
+                return 1;
+            }
+            if (child == 0) { //run the miner with its normal output discarded; SIGALRM ends it at the timeout
+                int devNull = open("/dev/null", O_WRONLY);
+                dup2(devNull, STDOUT_FILENO);
+                alarm(timeout);
+                vector<char*> childArgv;
+                for (string& arg : args)
+                    childArgv.push_back(&arg[0]);
+                childArgv.push_back(nullptr);
+                int status = runMiner(childArgv.size() - 1, childArgv.data());
+                cout.flush();
+                _exit(status);
+            }
+            int status;
+            waitpid(child, &status, 0);
+            double seconds = duration<double>(high_resolution_clock::now() - start).count();
+
+            bool finished = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            cerr << benchCase.name << " at " << supportText << ": "
+                 << (finished ? to_string(seconds) + " s" : WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM ? "timeout" : "failed") << "\n";
+            if (!finished) { //the run could not write its own line, nor delete its partition files
+                removePartitionFiles(tempDir, child);
+                ofstream out(benchFile, ios::app);
+                out << "{\"input\":" << jsonString(benchCase.name) << ",\"status\":"
+                    << (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM ? "\"timeout\"" : "\"failed\"")
+                    << ",\"min_support_fraction\":" << supportText << "}\n";
+            }
+            if (!finished || seconds > timeout / 4.0) //lower supports would only take longer
+                break;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) { //the benchmark and the generator have command lines of their own
+        string arg = argv[i];
+        if (arg == "--bench")
+            return runBenchmark(argc, argv);
+        if (arg == "--generate") { //fpgrowth --generate SPEC FILE
+            QuestParameters params;
+            if (i + 2 >= argc || !parseQuestSpec(argv[i + 1], params)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            if (!generateQuest(params, argv[i + 2])) {
+                cerr << "Cannot write file: " << argv[i + 2] << "\n";
+                return 1;
+            }
+            return 0;
+        }
+    }
+    return runMiner(argc, argv);
+}